@@ -0,0 +1,52 @@
+import matplotlib.pyplot as plt
+import pandas as pd
+import numpy as np
+
+# Roofs from benchmark_driver --roofline and the cells they were measured for
+roofs = pd.read_csv('../data/roofline.csv')
+df = pd.read_csv('../data/results.csv')
+
+# Only cells with a known flop count have a place under the roof
+df = df[df['intensity'].notna() & (df['gflops'] > 0)]
+
+# Latest roof of every thread count
+roofs = roofs.groupby('threads').last()
+
+for threads in sorted(df['threads'].unique()):
+    if threads not in roofs.index:
+        continue
+    roof = roofs.loc[threads]
+    subset = df[df['threads'] == threads]
+    aligned = subset[subset['offset'] == 0]
+    misaligned = subset[subset['offset'] != 0]
+
+    fig, ax = plt.subplots(figsize=(12, 8))
+
+    # Bandwidth roof up to the ridge, then the flat compute roof
+    ridge = roof['ridge_intensity']
+    x = np.logspace(np.log10(min(subset['intensity'].min(), ridge) / 4),
+                    np.log10(max(subset['intensity'].max(), ridge) * 4), 200)
+    ax.plot(x, np.minimum(roof['peak_gflops'], x * roof['bandwidth_gbps']), color='black', linewidth=2,
+            label=f"Roof ({roof['bandwidth_gbps']:.1f} GB/s, {roof['peak_gflops']:.1f} GFLOP/s)")
+    ax.axvline(ridge, color='gray', linestyle='--', alpha=0.5)
+    ax.text(ridge, roof['peak_gflops'] * 1.1, f'ridge {ridge:.2f} flop/B', ha='center', fontsize=9)
+
+    ax.scatter(aligned['intensity'], aligned['gflops'], color='green', alpha=0.7, label='Aligned')
+    ax.scatter(misaligned['intensity'], misaligned['gflops'], color='red', marker='x', alpha=0.7, label='Misaligned')
+
+    # One label per kernel, at its best cell
+    for kernel, cells in subset.groupby('kernel'):
+        best = cells.loc[cells['gflops'].idxmax()]
+        ax.annotate(kernel, (best['intensity'], best['gflops']), textcoords='offset points', xytext=(5, 5), fontsize=9)
+
+    ax.set_xscale('log')
+    ax.set_yscale('log')
+    ax.set_xlabel('Arithmetic intensity (flop/byte)')
+    ax.set_ylabel('GFLOP/s')
+    ax.set_title(f'Roofline (Threads={threads})')
+    ax.legend()
+    ax.grid(which='both', linestyle='--', alpha=0.5)
+
+    plt.tight_layout()
+    plt.savefig(f'roofline_threads_{threads}.png', dpi=300)
+    plt.show()
@@ -2,31 +2,27 @@ import matplotlib.pyplot as plt
 import pandas as pd
 import numpy as np
 
-# Read the CSV file
-csv_file = '../data/benchmark_results.csv'
+# Read the CSV file written by benchmark_driver
+csv_file = '../data/results.csv'
 df = pd.read_csv(csv_file)
 
-# Remove repeated headers if present
-if df.columns[0] == 'threads':
-    df = df[df['threads'] != 'threads']
-    df['threads'] = df['threads'].astype(int)
-    df['offset'] = df['offset'].astype(int)
-    df['aligned_time'] = df['aligned_time'].astype(float)
-    df['misaligned_time'] = df['misaligned_time'].astype(float)
-    df['speedup'] = df['speedup'].astype(float)
-    df['aligned_false_sharing'] = df['aligned_false_sharing'].astype(int)
-    df['misaligned_false_sharing'] = df['misaligned_false_sharing'].astype(int)
+# Scalar kernel, index partition; offset 0 is the aligned baseline of
+# every thread count and the other offsets are the misaligned runs
+df = df[(df['kernel'] == 'arith') & (df['partition'] == 'index')]
+aligned_df = df[df['offset'] == 0].groupby('threads').first()
+misaligned_df = df[df['offset'] != 0]
 
 # Get unique thread counts
-thread_counts = sorted(df['threads'].unique())
+thread_counts = sorted(misaligned_df['threads'].unique())
 
 for threads in thread_counts:
-    subset = df[df['threads'] == threads]
+    subset = misaligned_df[misaligned_df['threads'] == threads]
     offsets = subset['offset'].astype(int)
-    aligned = subset['aligned_time'].astype(float)
-    misaligned = subset['misaligned_time'].astype(float)
-    aligned_fs = subset['aligned_false_sharing'].astype(int)
-    misaligned_fs = subset['misaligned_false_sharing'].astype(int)
+    baseline = aligned_df.loc[threads]
+    aligned = pd.Series([float(baseline['time'])] * len(subset))
+    misaligned = subset['time'].astype(float)
+    aligned_fs = pd.Series([int(baseline['shared_lines'] > 0)] * len(subset))
+    misaligned_fs = (subset['shared_lines'] > 0).astype(int)
 
     x = np.arange(len(offsets))
     width = 0.35
@@ -1,8 +1,11 @@
 #!/bin/bash
 
-SRC="../src/compare_vector_add_alignment.cpp"
-BIN="../compare_vec"
+SRC="../src/benchmark_driver.cpp"
+BIN="../benchmark_driver"
+FLAGS="-O3 -fopenmp -march=native -std=c++17"   # recorded in every stored result
+REVISION=$(git describe --always --dirty --abbrev=12 2>/dev/null || echo unknown)   # stamped into the binary
 CSV="../data/vec_timing.csv"
+RESULTS="../data/vec_add_results.csv"
 PERF_ALIGNED="../data/perf_aligned.txt"
 PERF_MISALIGNED="../data/perf_misaligned.txt"
 
@@ -11,19 +14,30 @@ echo "📋 Capturing system information..."
 ./capture_system_info.sh
 
 echo "🔧 Building $SRC..."
-g++ -O3 -fopenmp -std=c++17 "$SRC" ../src/thread_utils.cpp -o "$BIN" || { echo "❌ Build failed"; exit 1; }
+g++ $FLAGS -DBUILD_FLAGS="\"$FLAGS\"" -DGIT_REVISION="\"$REVISION\"" "$SRC" ../src/benchmark_common.cpp ../src/kernel_registry.cpp ../src/thread_utils.cpp ../src/cache_info.cpp ../src/simd_kernels.cpp ../src/thread_pool.cpp ../src/numa_placement.cpp ../src/perf_counters.cpp ../src/write_tracker.cpp ../src/timeline.cpp ../src/measurement.cpp ../src/result_store.cpp ../src/false_sharing.cpp ../src/element_types.cpp ../src/work_scheduler.cpp ../src/huge_pages.cpp ../src/roofline.cpp -o "$BIN" || { echo "❌ Build failed"; exit 1; }
 
+# Regular and streaming add, aligned and 4 bytes off, in one process
 echo "🚀 Running $BIN..."
-OUTPUT=$(./$BIN)
+rm -f "$RESULTS"
+./$BIN --kernels=add,add_stream --offsets=0,4 --results="$RESULTS" > /dev/null || { echo "❌ Benchmark failed"; exit 1; }
 
-TIME_ALIGNED=$(echo "$OUTPUT" | grep "Aligned" | awk '{print $NF}')
-TIME_MISALIGNED=$(echo "$OUTPUT" | grep "Misaligned" | awk '{print $NF}')
+# Median of the measured runs of one kernel and offset
+get_time() {
+    awk -F',' -v k="$1" -v o="$2" 'NR==1 {for (i=1; i<=NF; i++) c[$i]=i; next}
+        $c["kernel"]==k && $c["offset"]==o {print $c["time"]; exit}' "$RESULTS"
+}
+
+TIME_ALIGNED=$(get_time add 0)
+TIME_MISALIGNED=$(get_time add 4)
+TIME_STREAM_ALIGNED=$(get_time add_stream 0)
+TIME_STREAM_MISALIGNED=$(get_time add_stream 4)
 
+# perf stat covers the whole process, so each buffer gets a run of its own
 echo "📊 Measuring perf stats (aligned)..."
-perf stat -e cache-misses,cache-references,cycles,instructions -o "$PERF_ALIGNED" -- ./$BIN > /dev/null
+perf stat -e cache-misses,cache-references,cycles,instructions -o "$PERF_ALIGNED" -- ./$BIN --kernels=add --offsets=0 --results=/dev/null > /dev/null
 
 echo "📊 Measuring perf stats (misaligned)..."
-perf stat -e cache-misses,cache-references,cycles,instructions -o "$PERF_MISALIGNED" -- ./$BIN > /dev/null
+perf stat -e cache-misses,cache-references,cycles,instructions -o "$PERF_MISALIGNED" -- ./$BIN --kernels=add --offsets=4 --results=/dev/null > /dev/null
 
 get_metric() {
     grep "$1" "$2" | awk '{gsub(",", "", $1); print $1}'
@@ -41,6 +55,9 @@ INST_MISALIGNED=$(get_metric "instructions" "$PERF_MISALIGNED")
 echo "version,exec_time_sec,cache_misses,cache_references,cycles,instructions" > "$CSV"
 echo "aligned,$TIME_ALIGNED,$MISS_ALIGNED,$REFS_ALIGNED,$CYCLES_ALIGNED,$INST_ALIGNED" >> "$CSV"
 echo "misaligned,$TIME_MISALIGNED,$MISS_MISALIGNED,$REFS_MISALIGNED,$CYCLES_MISALIGNED,$INST_MISALIGNED" >> "$CSV"
+# The perf runs only cover the regular stores, so the streaming rows only have times
+echo "aligned_stream,$TIME_STREAM_ALIGNED,,,," >> "$CSV"
+echo "misaligned_stream,$TIME_STREAM_MISALIGNED,,,," >> "$CSV"
 
 echo "✅ Benchmark complete. Data written to $CSV"
-rm -f "$PERF_ALIGNED" "$PERF_MISALIGNED"
\ No newline at end of file
+rm -f "$PERF_ALIGNED" "$PERF_MISALIGNED"
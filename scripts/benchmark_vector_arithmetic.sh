@@ -3,10 +3,14 @@
 # Vector Arithmetic Benchmark Script
 # Runs comprehensive benchmarks with different thread counts and offsets
 
-BIN="../vector_arithmetic_benchmark"
-CSV="../data/benchmark_results.csv"
+BIN="../benchmark_driver"
+FLAGS="-fopenmp -O3 -march=native -std=c++17"   # recorded in every stored result
+REVISION=$(git describe --always --dirty --abbrev=12 2>/dev/null || echo unknown)   # stamped into the binary
+CSV="../data/results.csv"
 PERF_ALIGNED="../data/perf_arithmetic_aligned.txt"
 PERF_MISALIGNED="../data/perf_arithmetic_misaligned.txt"
+PERF_THREADS="../data/perf_counters.csv"
+MEASUREMENTS="../data/measurements.jsonl"
 
 # Colors for output
 RED='\033[0;31m'
@@ -32,29 +36,30 @@ print_error() {
     echo -e "${RED}❌ $1${NC}"
 }
 
-# Check if binary exists
-if [ ! -f "$BIN" ]; then
-    print_error "Binary $BIN not found. Building..."
-    g++ -fopenmp -O3 -march=native -std=c++17 -o "$BIN" ../src/vector_arithmetic_benchmark.cpp ../src/thread_utils.cpp
-    if [ $? -ne 0 ]; then
-        print_error "Build failed!"
-        exit 1
-    fi
-    print_success "Build successful!"
+# Always rebuild, so the revision stamped into the stored results is the
+# one the binary was built from
+print_status "Building $BIN at revision $REVISION..."
+g++ $FLAGS -DBUILD_FLAGS="\"$FLAGS\"" -DGIT_REVISION="\"$REVISION\"" -o "$BIN" ../src/benchmark_driver.cpp ../src/benchmark_common.cpp ../src/kernel_registry.cpp ../src/thread_utils.cpp ../src/cache_info.cpp ../src/simd_kernels.cpp ../src/thread_pool.cpp ../src/numa_placement.cpp ../src/perf_counters.cpp ../src/write_tracker.cpp ../src/timeline.cpp ../src/measurement.cpp ../src/result_store.cpp ../src/false_sharing.cpp ../src/element_types.cpp ../src/work_scheduler.cpp ../src/huge_pages.cpp ../src/roofline.cpp
+if [ $? -ne 0 ]; then
+    print_error "Build failed!"
+    exit 1
 fi
+print_success "Build successful!"
 
 # Capture system information
 print_status "Capturing system information..."
 ./capture_system_info.sh
 
-# Clear previous results
+# Clear previous results; the result store is only appended to, so
+# compare_results can compare this run with earlier ones
 print_status "Clearing previous benchmark results..."
 rm -f "$CSV"
-rm -f "$PERF_ALIGNED" "$PERF_MISALIGNED"
+rm -f "$PERF_ALIGNED" "$PERF_MISALIGNED" "$PERF_THREADS"
 
 # Define test configurations
 THREAD_COUNTS=(2 4 8)
 OFFSETS=(4 8 16 32 64)
+KERNELS="arith,arith_simd"
 
 print_status "Starting comprehensive vector arithmetic benchmark..."
 echo "🧮 Vector Arithmetic Benchmark Suite"
@@ -62,27 +67,15 @@ echo "🧵 Thread counts: ${THREAD_COUNTS[*]}"
 echo "📏 Offsets: ${OFFSETS[*]} bytes"
 echo ""
 
-# Run benchmarks
-TOTAL_TESTS=$((${#THREAD_COUNTS[@]} * ${#OFFSETS[@]}))
-CURRENT_TEST=0
-
-for threads in "${THREAD_COUNTS[@]}"; do
-    for offset in "${OFFSETS[@]}"; do
-        CURRENT_TEST=$((CURRENT_TEST + 1))
-        print_status "Test $CURRENT_TEST/$TOTAL_TESTS: $threads threads, ${offset}B offset"
-        
-        # Run the benchmark
-        OUTPUT=$(./"$BIN" "$threads" "$offset" 2>&1)
-        
-        # Check if benchmark ran successfully
-        if [ $? -eq 0 ]; then
-            print_success "Completed: $threads threads, ${offset}B offset"
-        else
-            print_error "Failed: $threads threads, ${offset}B offset"
-            echo "$OUTPUT"
-        fi
-    done
-done
+# The driver runs the whole kernel x threads x offset matrix in one
+# process, reusing its buffers; offset 0 is the aligned baseline
+THREAD_LIST=$(IFS=,; echo "${THREAD_COUNTS[*]}")
+OFFSET_LIST=$(IFS=,; echo "0,${OFFSETS[*]}")
+if ./"$BIN" --kernels="$KERNELS" --threads="$THREAD_LIST" --offsets="$OFFSET_LIST" --partitions=index,line --counters; then
+    print_success "Completed: threads $THREAD_LIST, offsets $OFFSET_LIST"
+else
+    print_error "Benchmark failed"
+fi
 
 # Check if results were generated
 if [ ! -f "$CSV" ]; then
@@ -101,13 +94,7 @@ echo ""
 
 # Show sample results
 print_status "Sample results (first few lines):"
-head -10 "$CSV" | while IFS= read -r line; do
-    if [[ $line == threads* ]]; then
-        echo "  $line"
-    elif [[ $line =~ ^[0-9] ]]; then
-        echo "  $line"
-    fi
-done
+head -10 "$CSV" | sed 's/^/  /'
 
 # Generate performance analysis
 print_status "Generating performance analysis..."
@@ -123,25 +110,35 @@ SUMMARY_FILE="../data/benchmark_summary.txt"
     echo ""
     echo "=== Performance Summary ==="
     
+    # Columns by name; the misaligned rows of the scalar kernel with the
+    # index partition are compared with offset 0 of the same thread count
+    COLS='NR==1 {for (i=1; i<=NF; i++) c[$i]=i; next} $c["kernel"]=="arith" && $c["partition"]=="index"'
+
     # Calculate averages for each thread count
     for threads in "${THREAD_COUNTS[@]}"; do
         echo "Threads: $threads"
-        echo "  Average aligned time: $(awk -F',' -v t="$threads" '$1==t {sum+=$3; count++} END {if(count>0) printf "%.6f", sum/count}' "$CSV")s"
-        echo "  Average misaligned time: $(awk -F',' -v t="$threads" '$1==t {sum+=$4; count++} END {if(count>0) printf "%.6f", sum/count}' "$CSV")s"
-        echo "  Average speedup: $(awk -F',' -v t="$threads" '$1==t {sum+=$5; count++} END {if(count>0) printf "%.3f", sum/count}' "$CSV")x"
+        echo "  Average aligned time: $(awk -F',' -v t="$threads" "$COLS"' && $c["threads"]==t && $c["offset"]==0 {sum+=$c["time"]; count++} END {if(count>0) printf "%.6f", sum/count}' "$CSV")s"
+        echo "  Average misaligned time: $(awk -F',' -v t="$threads" "$COLS"' && $c["threads"]==t && $c["offset"]!=0 {sum+=$c["time"]; count++} END {if(count>0) printf "%.6f", sum/count}' "$CSV")s"
+        echo "  Average speedup: $(awk -F',' -v t="$threads" "$COLS"' && $c["threads"]==t && $c["offset"]!=0 {sum+=$c["vs_aligned"]; count++} END {if(count>0) printf "%.3f", sum/count}' "$CSV")x"
         echo ""
     done
     
     echo "=== False Sharing Analysis ==="
-    TOTAL_RUNS=$(grep -c '^[0-9]' "$CSV")
-    ALIGNED_FS=$(awk -F',' '$6==1 {count++} END {print count}' "$CSV")
-    MISALIGNED_FS=$(awk -F',' '$7==1 {count++} END {print count}' "$CSV")
+    TOTAL_RUNS=$(awk -F',' "$COLS"' {count++} END {print count+0}' "$CSV")
+    ALIGNED_FS=$(awk -F',' "$COLS"' && $c["offset"]==0 && $c["shared_lines"]>0 {count++} END {print count+0}' "$CSV")
+    MISALIGNED_FS=$(awk -F',' "$COLS"' && $c["offset"]!=0 && $c["shared_lines"]>0 {count++} END {print count+0}' "$CSV")
     
     echo "Total benchmark runs: $TOTAL_RUNS"
     echo "Aligned memory with false sharing: $ALIGNED_FS"
     echo "Misaligned memory with false sharing: $MISALIGNED_FS"
     echo "False sharing rate (aligned): $(awk -v a="$ALIGNED_FS" -v t="$TOTAL_RUNS" 'BEGIN {if(t>0) printf "%.1f", a*100/t; else print "0"}')%"
     echo "False sharing rate (misaligned): $(awk -v m="$MISALIGNED_FS" -v t="$TOTAL_RUNS" 'BEGIN {if(t>0) printf "%.1f", m*100/t; else print "0"}')%"
+    echo ""
+    echo "=== Measurement Quality ==="
+    # A speedup is significant when the 95% CIs of the two means do not overlap
+    SIGNIFICANT=$(awk -F',' "$COLS"' && $c["vs_aligned_significant"]==1 {count++} END {print count+0}' "$CSV")
+    echo "Speedups outside the noise: $SIGNIFICANT of $TOTAL_RUNS"
+    echo "Per-configuration statistics (appended to earlier runs): $MEASUREMENTS"
     
 } > "$SUMMARY_FILE"
 
@@ -173,6 +170,7 @@ print_success "Benchmark suite completed!"
 echo "📁 Files generated:"
 echo "  - $CSV (detailed results)"
 echo "  - $SUMMARY_FILE (performance summary)"
+echo "  - $MEASUREMENTS (per-configuration statistics, appended)"
 echo "  - ../data/system_info.txt (system details)"
 echo "  - ../plots/vec_benchmark_threads_*_with_false_sharing.png (plots)"
 
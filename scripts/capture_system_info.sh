@@ -47,6 +47,13 @@ if [ -f /proc/meminfo ]; then
     echo "Total Memory: $(grep MemTotal /proc/meminfo | awk '{print $2 " " $3}')" >> "$OUTPUT_FILE"
     echo "Available Memory: $(grep MemAvailable /proc/meminfo | awk '{print $2 " " $3}')" >> "$OUTPUT_FILE"
 fi
+if [ -f /sys/kernel/mm/transparent_hugepage/enabled ]; then
+    echo "Transparent Huge Pages: $(cat /sys/kernel/mm/transparent_hugepage/enabled)" >> "$OUTPUT_FILE"
+fi
+for pool in /sys/kernel/mm/hugepages/hugepages-*; do
+    [ -d "$pool" ] || continue
+    echo "HugeTLB $(basename "$pool" | sed 's/hugepages-//'): $(cat "$pool/free_hugepages") free of $(cat "$pool/nr_hugepages")" >> "$OUTPUT_FILE"
+done
 echo "" >> "$OUTPUT_FILE"
 
 # NUMA Information
@@ -112,5 +119,14 @@ echo "Default C++ Standard: $(g++ -dM -E - < /dev/null | grep __cplusplus | cut
 echo "OpenMP Version: $(gcc -fopenmp -dM -E - < /dev/null | grep _OPENMP | cut -d' ' -f3)" >> "$OUTPUT_FILE"
 echo "" >> "$OUTPUT_FILE"
 
+# Machine fingerprint, as recorded in the "run" object of every stored result
+echo "=== Result Store ===" >> "$OUTPUT_FILE"
+if [ -x ../compare_results ]; then
+    ../compare_results --fingerprint >> "$OUTPUT_FILE"
+else
+    echo "Fingerprint not available (build compare_results)" >> "$OUTPUT_FILE"
+fi
+echo "" >> "$OUTPUT_FILE"
+
 echo "System information captured in: $OUTPUT_FILE"
 echo "=== End of System Information ===" >> "$OUTPUT_FILE" 
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "benchmark_common.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <x86intrin.h>
+
+int get_num_threads()
+{
+	const char* env = std::getenv("OMP_NUM_THREADS");
+	return env ? std::atoi(env) : 4;
+}
+
+bool file_is_empty(const char* path)
+{
+	std::ifstream in(path);
+	return !in.good() || in.peek() == std::ifstream::traits_type::eof();
+}
+
+bool open_csv(std::ofstream& out, const std::string& path, const std::string& header)
+{
+	bool write_header = file_is_empty(path.c_str());
+	if (!write_header) {
+		std::string first;
+		std::ifstream in(path);
+		std::getline(in, first);
+		in.close();
+		if (first != header) {
+			std::string rotated;
+			for (int i = 1; ; ++i) {
+				rotated = path + "." + std::to_string(i);
+				if (!std::ifstream(rotated).good()) break;
+			}
+			if (std::rename(path.c_str(), rotated.c_str()) != 0) {
+				std::cerr << "Cannot move " << path << " (old columns) to " << rotated << "\n";
+				return false;
+			}
+			std::cout << "📁 " << path << " has other columns, moved to " << rotated << "\n";
+			write_header = true;
+		}
+	}
+	out.open(path, std::ios::app);
+	if (!out) return false;
+	if (write_header) out << header << "\n";
+	return true;
+}
+
+std::vector<std::string> split_list(const char* list)
+{
+	std::vector<std::string> items;
+	std::string item;
+	for (const char* p = list; ; ++p) {
+		if (*p == ',' || *p == '\0') {
+			if (!item.empty()) items.push_back(item);
+			item.clear();
+			if (*p == '\0') break;
+		} else {
+			item += *p;
+		}
+	}
+	return items;
+}
+
+bool parse_count(const std::string& text, std::size_t* count)
+{
+	char* end = nullptr;
+	unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+	if (end == text.c_str()) return false;
+	switch (*end) {
+		case 'K': case 'k': value <<= 10; ++end; break;
+		case 'M': case 'm': value <<= 20; ++end; break;
+		case 'G': case 'g': value <<= 30; ++end; break;
+		default: break;
+	}
+	if (*end != '\0' || value == 0) return false;
+	*count = static_cast<std::size_t>(value);
+	return true;
+}
+
+double tsc_ticks_per_ns()
+{
+	auto start = std::chrono::steady_clock::now();
+	uint64_t tsc_start = __rdtsc();
+	while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50)) {}
+	uint64_t ticks = __rdtsc() - tsc_start;
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	return ticks / ns;
+}
+
+void print_page_nodes(const char* label, const void* data, std::size_t bytes)
+{
+	std::vector<std::size_t> counts = pages_per_node(data, bytes);
+	std::cout << "🗺️  " << label << " pages per node:";
+	if (counts.empty()) std::cout << " unknown";
+	for (std::size_t node = 0; node < counts.size(); ++node)
+		if (counts[node]) std::cout << " node" << node << "=" << counts[node];
+	std::cout << "\n";
+}
@@ -0,0 +1,48 @@
+#ifndef BENCHMARK_COMMON_H
+#define BENCHMARK_COMMON_H
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "measurement.h"
+#include "numa_placement.h"
+
+#define CACHE_LINE_SIZE 64
+#define MEASUREMENTS_PATH "../data/measurements.jsonl"
+
+// Thread pinning and page placement of a run
+struct placement_t
+{
+	pin_policy_t pin;
+	mem_policy_t mem;
+	int          node;   // target node of MEM_BIND
+};
+
+// Number of threads from the OMP_NUM_THREADS env variable, 4 if unset
+int get_num_threads();
+
+// True if path does not exist or has no content yet, i.e. a CSV needs its header
+bool file_is_empty(const char* path);
+
+// Open path for appending rows under header (without the newline). A new
+// or empty file gets the header. A file whose first line is another header,
+// written by an older build, is renamed to path.1 (or the next free number)
+// and started again, so rows of two layouts never share a file. Returns
+// false if the file cannot be opened.
+bool open_csv(std::ofstream& out, const std::string& path, const std::string& header);
+
+// Split "a,b,c" at the commas; empty items are dropped
+std::vector<std::string> split_list(const char* list);
+
+// Parse a count with an optional K, M or G suffix (powers of 1024);
+// returns false on anything else or on 0
+bool parse_count(const std::string& text, std::size_t* count);
+
+// TSC ticks per nanosecond, from a short busy wait against steady_clock
+double tsc_ticks_per_ns();
+
+// Print how the sampled pages of a buffer are spread over NUMA nodes
+void print_page_nodes(const char* label, const void* data, std::size_t bytes);
+
+#endif // BENCHMARK_COMMON_H
@@ -0,0 +1,1025 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include <cctype>
+#include "benchmark_common.h"
+#include "kernel_registry.h"
+#include "thread_utils.h"
+#include "cache_info.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+#include "numa_placement.h"
+#include "perf_counters.h"
+#include "measurement.h"
+#include "result_store.h"
+#include "false_sharing.h"
+#include "element_types.h"
+#include "work_scheduler.h"
+#include "huge_pages.h"
+#include "write_tracker.h"
+#include "roofline.h"
+#include "timeline.h"
+
+#define DEFAULT_SIZE "1M"
+#define RESULTS_PATH "../data/results.csv"
+#define PERF_THREADS_PATH "../data/perf_counters.csv"
+#define PIPELINE_PATH "../data/pipeline_results.csv"
+#define ROOFLINE_PATH "../data/roofline.csv"
+#define TRACK_RUNS 10                // Tracked runs per cell after the measurement
+#define TRACK_SAMPLES (1 << 16)      // Samples kept per thread and cell
+#define TRACE_PATH "../data/trace.json"
+#define TRACE_RUNS 5                 // Traced runs per cell after the measurement
+#define TRACE_EVENTS (1 << 16)       // Timeline events kept per thread
+
+// Working set of one row of the matrix: a fixed element count, or a cache
+// level whose sweep point is split between the arrays of the kernel
+struct size_spec_t {
+    std::string level;   // "L1", "L2", "L3", "DRAM" or empty
+    size_t bytes;        // working set of a level
+    size_t elements;     // explicit element count
+};
+
+// Elements of kernel for a size
+dim_t size_elements(const size_spec_t& size, const kernel_desc_t& kernel) {
+    if (size.level.empty()) return size.elements;
+    return size.bytes / ((kernel.inputs + 1) * kernel.elem_size);
+}
+
+// Everything the matrix is run over, from the command line
+struct matrix_t {
+    std::vector<std::string> kernels;
+    std::vector<elem_type_t> types;
+    std::vector<int> threads;
+    std::vector<size_t> offsets;
+    std::vector<size_spec_t> sizes;
+    std::vector<kernel_split_t> splits;
+    std::vector<std::vector<std::string>> pipelines;   // stage names of each --pipelines entry
+    size_t block_bytes;                                 // of out per fused block; 0: from the L2 size
+};
+
+// The three arrays every kernel call is pointed into. They are allocated
+// once for the largest cell and reused by every kernel, thread count,
+// offset and size; the misaligned output starts offset bytes into out.
+struct workspace_t {
+    char* in0;
+    char* in1;
+    char* out;
+    size_t bytes;   // of each array
+};
+
+workspace_t allocate_workspace(size_t bytes) {
+    workspace_t ws;
+    ws.bytes = bytes;
+    ws.in0 = allocate_aligned_buffer<char>(bytes);
+    ws.in1 = allocate_aligned_buffer<char>(bytes);
+    ws.out = allocate_aligned_buffer<char>(bytes);
+    return ws;
+}
+
+void free_workspace(workspace_t& ws) {
+    free_aligned_buffer(ws.in0);
+    free_aligned_buffer(ws.in1);
+    free_aligned_buffer(ws.out);
+    ws = {};
+}
+
+// Place the pages of the workspace under the memory policy and touch them
+// from the main thread. MEM_FIRST_TOUCH leaves them alone: the threads of
+// every cell place the part that cell uses, see prepare_cell().
+void place_workspace(workspace_t& ws, const placement_t& placement) {
+    if (placement.mem == MEM_FIRST_TOUCH) return;
+    char* arrays[3] = { ws.in0, ws.in1, ws.out };
+    for (char* data : arrays) {
+        apply_mem_policy(data, ws.bytes, placement.mem, placement.node);
+        std::memset(data, 0, ws.bytes);
+    }
+    print_page_nodes("Workspace out", ws.out, ws.bytes);
+}
+
+// Fill the buffers of one cell. The workspace is shared by cells of every
+// size, type, offset and partition, so with MEM_FIRST_TOUCH the pages the
+// cell uses are dropped first: the parallel fill then touches them again,
+// and every thread's range under this cell's partition lands on its node.
+// Huge pages are dropped whole, so they stay huge; the partial ones at the
+// ends of a cell keep their earlier placement.
+void prepare_cell(const kernel_desc_t& kernel, const kernel_call_t& call, partition_t partition,
+                  ParallelExecutor& exec, const placement_t& placement) {
+    static bool discard_failed = false;
+    static bool huge_noted = false;
+    if (placement.mem == MEM_FIRST_TOUCH && !discard_failed) {
+        page_backend_t pages = used_page_backend();
+        size_t page_bytes = page_backend_size(pages);
+        if (pages != PAGES_DEFAULT && !huge_noted) {
+            std::cout << "📄 First touch drops whole " << (page_bytes >> 10) << " KiB " << page_backend_name(pages)
+                      << " pages; a cell re-places only the huge pages it covers completely\n";
+            huge_noted = true;
+        }
+        size_t bytes = call.n * kernel.elem_size;
+        discard_failed = !discard_pages(const_cast<void*>(call.in0), bytes, page_bytes) ||
+                         !discard_pages(const_cast<void*>(call.in1), bytes, page_bytes) ||
+                         !discard_pages(call.out, bytes, page_bytes);
+        if (discard_failed)
+            std::cout << "⚠️  " << page_backend_name(pages)
+                      << " pages cannot be dropped, first touch keeps the first cell's placement\n";
+    }
+    init_kernel_buffers(kernel, call, partition, exec);
+    if (placement.mem == MEM_FIRST_TOUCH && !discard_failed)
+        print_page_nodes("Cell out", call.out, call.n * kernel.elem_size);
+}
+
+// Print the per-thread counters of the last measurement, append them to the
+// per-thread CSV and return the per-run totals over all threads
+perf_counts_t report_counters(PerfCounters* counters, int num_runs, const kernel_desc_t& kernel,
+                              const char* buffer, size_t offset_bytes, std::ofstream& thread_csv) {
+    perf_counts_t total = {};
+    if (!counters) return total;
+
+    int num_threads = counters->num_threads();
+    std::cout << "   📟 thread      cycles        instr   IPC   l1d_miss   llc_miss       hitm\n";
+    for (int t = 0; t < num_threads; ++t) {
+        const perf_counts_t& c = counters->thread_counts(t);
+        double per_run[PERF_NUM_EVENTS];
+        for (int e = 0; e < PERF_NUM_EVENTS; ++e) per_run[e] = c.value[e] / num_runs;
+        printf("   📟 %6d %11.0f %12.0f %5.2f %10.0f %10.0f %10.0f\n", t,
+               per_run[PERF_EV_CYCLES], per_run[PERF_EV_INSTRUCTIONS],
+               per_run[PERF_EV_CYCLES] > 0 ? per_run[PERF_EV_INSTRUCTIONS] / per_run[PERF_EV_CYCLES] : 0.0,
+               per_run[PERF_EV_L1D_MISSES], per_run[PERF_EV_LLC_MISSES], per_run[PERF_EV_HITM]);
+
+        thread_csv << num_threads << "," << offset_bytes << "," << kernel.name << "," << buffer << "," << t;
+        for (int e = 0; e < PERF_NUM_EVENTS; ++e) {
+            thread_csv << ",";
+            if (counters->available(static_cast<perf_event_id_t>(e))) thread_csv << per_run[e];
+        }
+        thread_csv << "\n";
+    }
+
+    perf_counts_t sum = counters->total();
+    for (int e = 0; e < PERF_NUM_EVENTS; ++e) total.value[e] = sum.value[e] / num_runs;
+    return total;
+}
+
+// Wall time statistics of the measured runs of run_once(), which returns
+// its in-kernel time; kernel_stats receives the in-kernel time of the same
+// runs, the rest is fork/join and barrier cost of the backend. Counters and
+// scheduler stats only cover the measured runs.
+template <typename F>
+measure_stats_t measure_cell(ParallelExecutor& exec, ChunkScheduler& sched, const measure_config_t& config,
+                             F run_once, measure_stats_t* kernel_stats) {
+    std::vector<double> kernel_times;
+    measure_stats_t stats = measure(config, [&](int run) {
+        if (run == 0) {
+            if (exec.counters()) exec.counters()->reset();
+            sched.reset_stats();
+        }
+        auto start = std::chrono::steady_clock::now();
+        double kernel_time = run_once();
+        auto end = std::chrono::steady_clock::now();
+        if (run >= 0) kernel_times.push_back(kernel_time);
+        return std::chrono::duration<double>(end - start).count();
+    });
+    *kernel_stats = summarize_samples(kernel_times);
+    return stats;
+}
+
+// Run the cell TRACK_RUNS more times with the write tracker enabled and
+// return what it saw; overhead receives the slowdown of the median tracked
+// run against the untracked median
+write_tracking_report_t track_cell(const kernel_desc_t& kernel, const kernel_call_t& call, const kernel_split_t& split,
+                                   ParallelExecutor& exec, ChunkScheduler& sched, const measure_stats_t& untracked,
+                                   double* overhead) {
+    WriteTracker* tracker = exec.tracker();
+    tracker->reset();
+    tracker->set_enabled(true);
+    std::vector<double> times;
+    for (int run = 0; run < TRACK_RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        run_kernel(kernel, call, split, exec, sched);
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double>(end - start).count());
+    }
+    tracker->set_enabled(false);
+    *overhead = summarize_samples(times).median / untracked.median - 1.0;
+    return tracker->report();
+}
+
+// Run the cell TRACE_RUNS more times with the timeline enabled, add them
+// to the trace as one process named label and return the per-thread summary
+timeline_summary_t trace_cell(const kernel_desc_t& kernel, const kernel_call_t& call, const kernel_split_t& split,
+                              ParallelExecutor& exec, ChunkScheduler& sched, const std::string& label,
+                              ChromeTraceWriter& trace) {
+    Timeline* timeline = exec.timeline();
+    timeline->reset();
+    timeline->set_enabled(true);
+    for (int run = 0; run < TRACE_RUNS; ++run) run_kernel(kernel, call, split, exec, sched);
+    timeline->set_enabled(false);
+    trace.add(*timeline, label);
+    return timeline->summary();
+}
+
+// Name of a split for the console, e.g. "line" or "chunks/steal"
+std::string split_label(const kernel_desc_t& kernel, const kernel_split_t& split) {
+    if (kernel.cyclic) return partition_name(PARTITION_CYCLIC);
+    std::string label = partition_name(split.partition);
+    if (split.partition == PARTITION_CHUNKS) label += std::string("/") + schedule_name(split.schedule);
+    return label;
+}
+
+// Run every kernel x type x size x split x offset cell on one thread
+// count; with a roof every cell is also placed on the roofline, and with
+// a timeline attached to exec every cell is traced into trace
+void run_thread_count(const matrix_t& matrix, ParallelExecutor& exec, const workspace_t& ws,
+                      const placement_t& placement, const measure_config_t& config, simd_isa_t isa,
+                      double skew, const roofline_t* roof, ChromeTraceWriter& trace, std::ofstream& csv,
+                      std::ofstream& thread_csv) {
+    int num_threads = exec.num_threads();
+    ChunkScheduler sched(num_threads);
+
+    for (elem_type_t type : matrix.types) {
+        for (const size_spec_t& size : matrix.sizes) {
+            for (const std::string& name : matrix.kernels) {
+                const kernel_desc_t* kernel = find_kernel(name, type);
+                if (!kernel) {
+                    std::cout << "⏭️  " << name << " has no " << elem_type_name(type) << " version, skipped\n";
+                    continue;
+                }
+                dim_t n = size_elements(size, *kernel);
+                double bytes_moved = kernel->bytes_per_elem * n;
+
+                // A cyclic kernel splits the index space itself, so it gets one split
+                std::vector<kernel_split_t> splits = matrix.splits;
+                if (kernel->cyclic) splits.assign(1, { PARTITION_CYCLIC, SCHED_STATIC, 0 });
+
+                for (const kernel_split_t& split : splits) {
+                    if (split.partition == PARTITION_CHUNKS && !schedule_supported(split.schedule, exec.backend())) {
+                        std::cout << "⏭️  " << name << " " << schedule_name(split.schedule) << ": needs --backend=omp, skipped\n";
+                        continue;
+                    }
+                    std::string label = split_label(*kernel, split);
+                    measure_stats_t aligned = {};
+                    bool have_aligned = false;
+                    std::vector<size_t> done;
+
+                    for (size_t requested : matrix.offsets) {
+                        size_t offset_bytes = misalign_offset(requested, kernel->elem_size);
+                        // Different offsets can round to the same element boundary
+                        if (std::find(done.begin(), done.end(), offset_bytes) != done.end()) continue;
+                        done.push_back(offset_bytes);
+
+                        kernel_call_t call = { ws.in0, ws.in1, ws.out + offset_bytes, n, isa, skew };
+                        // Refill before every cell: the in-place kernels change their data
+                        prepare_cell(*kernel, call, kernel->cyclic ? PARTITION_CYCLIC : split.partition, exec, placement);
+
+                        measure_stats_t kernel_time;
+                        measure_stats_t time = measure_cell(exec, sched, config,
+                            [&]() { return run_kernel(*kernel, call, split, exec, sched); }, &kernel_time);
+                        sched_stats_t sched_stats = sched.stats();
+                        false_sharing_report_t sharing = analyze_false_sharing(
+                            kernel_accesses(*kernel, call, split, num_threads), CACHE_LINE_SIZE);
+
+                        if (offset_bytes == 0) { aligned = time; have_aligned = true; }
+                        double gbps = bytes_moved / time.median / 1e9;
+                        bool significant = have_aligned && stats_differ(aligned, time);
+
+                        std::cout << (sharing.shared.empty() ? "✅ " : "⚠️  ") << kernel->name << " "
+                                  << elem_type_name(type) << " " << n << " el"
+                                  << (size.level.empty() ? "" : " (" + size.level + ")") << ", "
+                                  << num_threads << " threads, " << label << ", offset " << offset_bytes << ": "
+                                  << time.median << " sec, " << gbps << " GB/s (CV " << time.cv * 100.0 << "%, "
+                                  << time.runs << " runs), kernel " << kernel_time.median << " sec";
+                        if (have_aligned && offset_bytes != 0)
+                            std::cout << ", " << time.median / aligned.median << "x aligned" << (significant ? "" : " (within noise)");
+                        if (!sharing.shared.empty())
+                            std::cout << ", " << sharing.total_lines << " shared lines";
+                        if (split.partition == PARTITION_CHUNKS)
+                            std::cout << ", imbalance " << sched_stats.imbalance << ", "
+                                      << static_cast<double>(sched_stats.steals) / time.runs << " steals/run";
+                        // Position on the roofline, for kernels with a known flop count
+                        double intensity = kernel->flops_per_elem / kernel->bytes_per_elem;
+                        double gflops = kernel->flops_per_elem * n / time.median / 1e9;
+                        double attainable = roof ? attainable_gflops(*roof, intensity) : 0.0;
+                        if (kernel->flops_per_elem > 0.0) {
+                            std::cout << ", " << gflops << " GFLOP/s at " << intensity << " flop/B";
+                            if (roof)
+                                std::cout << " (" << roofline_bound(*roof, intensity) << " bound, "
+                                          << gflops / attainable * 100.0 << "% of roof)";
+                        }
+                        std::cout << "\n";
+
+                        const char* buffer = offset_bytes ? "misaligned" : "aligned";
+                        perf_counts_t counts = report_counters(exec.counters(), time.runs, *kernel, buffer, offset_bytes, thread_csv);
+
+                        // Sampled writes of real runs, against the prediction above
+                        write_tracking_report_t tracked = {};
+                        double tracking_overhead = 0.0;
+                        if (exec.tracker()) {
+                            tracked = track_cell(*kernel, call, split, exec, sched, time, &tracking_overhead);
+                            print_write_tracking_report(tracked, 4);
+                            std::cout << "   measured slowdown " << tracking_overhead * 100.0 << "% over "
+                                      << TRACK_RUNS << " tracked runs\n";
+                        }
+
+                        // When each thread ran, to name the straggler
+                        timeline_summary_t traced = {};
+                        if (exec.timeline()) {
+                            std::string cell = std::string(kernel->name) + " " + elem_type_name(type) + " " + std::to_string(n)
+                                               + " el, " + std::to_string(num_threads) + " threads, " + label
+                                               + ", offset " + std::to_string(offset_bytes);
+                            traced = trace_cell(*kernel, call, split, exec, sched, cell, trace);
+                            print_timeline_summary(traced, *exec.timeline());
+                        }
+
+                        csv << kernel->name << "," << elem_type_name(type) << "," << kernel->elem_size << ","
+                            << size.level << "," << n << "," << n * (kernel->inputs + 1) * kernel->elem_size << ","
+                            << num_threads << "," << offset_bytes << "," << partition_name(kernel->cyclic ? PARTITION_CYCLIC : split.partition) << ","
+                            << (split.partition == PARTITION_CHUNKS ? schedule_name(split.schedule) : "") << ","
+                            << (split.partition == PARTITION_CHUNKS ? split.chunk_lines : 0) << ","
+                            << simd_isa_name(isa) << "," << exec_backend_name(exec.backend()) << ","
+                            << pin_policy_name(placement.pin) << "," << mem_policy_name(placement.mem) << ","
+                            << page_backend_name(used_page_backend()) << ","
+                            << time.median << "," << time.min << "," << time.p90 << "," << time.p99 << "," << time.cv << ","
+                            << time.runs << "," << time.converged << "," << kernel_time.median << "," << gbps << ",";
+                        if (have_aligned) csv << time.median / aligned.median;
+                        csv << "," << significant << "," << sharing.total_lines << "," << sharing.total_bytes << ",";
+                        if (split.partition == PARTITION_CHUNKS)
+                            csv << sched_stats.imbalance << "," << static_cast<double>(sched_stats.steals) / time.runs;
+                        else
+                            csv << ",";
+                        for (int e = 0; e < PERF_NUM_EVENTS; ++e) {
+                            csv << ",";
+                            if (exec.counters() && exec.counters()->available(static_cast<perf_event_id_t>(e)))
+                                csv << counts.value[e];
+                        }
+                        csv << ",";
+                        if (exec.tracker()) csv << tracked.shared.size() << "," << tracking_overhead;
+                        else csv << ",";
+                        csv << ",";
+                        if (kernel->flops_per_elem > 0.0) csv << intensity << "," << gflops;
+                        else csv << ",";
+                        csv << ",";
+                        if (roof && kernel->flops_per_elem > 0.0)
+                            csv << attainable << "," << roofline_bound(*roof, intensity) << "," << gflops / attainable;
+                        else
+                            csv << ",,";
+                        csv << ",";
+                        if (traced.runs)
+                            csv << traced.imbalance << "," << traced.straggler << "," << traced.start_spread * 1e6 << ","
+                                << traced.finish_spread * 1e6;
+                        else
+                            csv << ",,,";
+                        csv << "\n";
+
+                        JsonRecord record;
+                        record.add("benchmark", "driver")
+                              .add("kernel", kernel->name)
+                              .add("type", elem_type_name(type))
+                              .add("elem_size", kernel->elem_size)
+                              .add("buffer", buffer)
+                              .add("partition", partition_name(kernel->cyclic ? PARTITION_CYCLIC : split.partition))
+                              .add("elements", static_cast<long long>(n))
+                              .add("threads", num_threads)
+                              .add("offset", offset_bytes)
+                              .add("isa", simd_isa_name(isa))
+                              .add("backend", exec_backend_name(exec.backend()))
+                              .add("pin", pin_policy_name(placement.pin))
+                              .add("mem", mem_policy_name(placement.mem))
+                              .add("pages", page_backend_name(used_page_backend()));
+                        if (!size.level.empty()) record.add("level", size.level);
+                        if (split.partition == PARTITION_CHUNKS)
+                            record.add("schedule", schedule_name(split.schedule))
+                                  .add("chunk_lines", static_cast<long long>(split.chunk_lines));
+                        if (exec.tracker()) record.add("tracking", track_backend_name(tracked.backend));
+
+                        JsonRecord result;
+                        result.add("time", time)
+                              .add("kernel_time", kernel_time)
+                              .add("gbps", gbps)
+                              .add("shared_lines", static_cast<long long>(sharing.total_lines));
+                        if (split.partition == PARTITION_CHUNKS)
+                            result.add("imbalance", sched_stats.imbalance)
+                                  .add("steals_per_run", static_cast<double>(sched_stats.steals) / time.runs);
+                        if (exec.tracker())
+                            result.add("tracked_shared_lines", tracked.shared.size())
+                                  .add("tracked_samples", static_cast<long long>(tracked.samples))
+                                  .add("tracking_overhead", tracking_overhead);
+                        if (traced.runs)
+                            result.add("trace_imbalance", traced.imbalance)
+                                  .add("straggler", traced.straggler)
+                                  .add("start_spread_us", traced.start_spread * 1e6)
+                                  .add("finish_spread_us", traced.finish_spread * 1e6);
+                        if (kernel->flops_per_elem > 0.0) {
+                            result.add("intensity", intensity).add("gflops", gflops);
+                            if (roof)
+                                result.add("attainable_gflops", attainable)
+                                      .add("roofline_bound", roofline_bound(*roof, intensity));
+                        }
+                        store_result(MEASUREMENTS_PATH, record, result);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Name of a pipeline, e.g. "add+arith_simd"
+std::string pipeline_name(const std::vector<std::string>& stages) {
+    std::string name;
+    for (const std::string& stage : stages) name += (name.empty() ? "" : "+") + stage;
+    return name;
+}
+
+// Bytes of out per fused block: the given size, or enough that a block of
+// out and of each input of the first stage fill half the L2, in whole lines
+size_t fused_block_bytes(const matrix_t& matrix, const kernel_desc_t& first, const cache_info_t& cache) {
+    size_t bytes = matrix.block_bytes ? matrix.block_bytes : cache.l2_size / (2 * (first.inputs + 1));
+    return std::max<size_t>(bytes / CACHE_LINE_SIZE * CACHE_LINE_SIZE, CACHE_LINE_SIZE);
+}
+
+// LLC read misses per run over all threads, or -1 without counters
+double llc_misses_per_run(ParallelExecutor& exec, int runs) {
+    if (!exec.counters() || !exec.counters()->available(PERF_EV_LLC_MISSES)) return -1.0;
+    return exec.counters()->total().value[PERF_EV_LLC_MISSES] / runs;
+}
+
+// Run every pipeline x type x size x split x offset cell on one thread
+// count, unfused and fused. Returns false if the two modes compute
+// different results.
+bool run_pipelines(const matrix_t& matrix, ParallelExecutor& exec, const workspace_t& ws, const placement_t& placement,
+                   const measure_config_t& config, simd_isa_t isa, double skew, const cache_info_t& cache,
+                   std::ofstream& csv) {
+    int num_threads = exec.num_threads();
+    ChunkScheduler sched(num_threads);
+
+    for (const std::vector<std::string>& names : matrix.pipelines) {
+        std::string name = pipeline_name(names);
+        for (elem_type_t type : matrix.types) {
+            std::vector<const kernel_desc_t*> stages;
+            for (const std::string& stage : names)
+                if (const kernel_desc_t* kernel = find_kernel(stage, type)) stages.push_back(kernel);
+            std::string error;
+            bool valid = stages.size() == names.size() && pipeline_valid(stages, &error);
+            if (!valid) {
+                if (error.empty()) error = "a stage has no " + std::string(elem_type_name(type)) + " version";
+                std::cout << "⏭️  " << name << " " << elem_type_name(type) << ": " << error << ", skipped\n";
+                continue;
+            }
+            const kernel_desc_t& first = *stages[0];
+            size_t block_bytes = fused_block_bytes(matrix, first, cache);
+            dim_t block_elems = std::max<dim_t>(block_bytes / first.elem_size, 1);
+
+            // Fused blocks walk the ranges of kernel_block_range(), which has no chunk schedule
+            for (const kernel_split_t& split : matrix.splits)
+                if (split.partition == PARTITION_CHUNKS)
+                    std::cout << "⏭️  " << name << " " << elem_type_name(type) << " " << schedule_name(split.schedule)
+                              << ": fused stages have no chunk schedule, skipped\n";
+
+            for (const size_spec_t& size : matrix.sizes) {
+                dim_t n = size_elements(size, first);
+                double unfused_bytes = pipeline_bytes_per_elem(stages, false) * n;
+                double fused_bytes = pipeline_bytes_per_elem(stages, true) * n;
+
+                for (const kernel_split_t& split : matrix.splits) {
+                    if (split.partition == PARTITION_CHUNKS) continue;
+                    std::vector<size_t> done;
+                    for (size_t requested : matrix.offsets) {
+                        size_t offset_bytes = misalign_offset(requested, first.elem_size);
+                        if (std::find(done.begin(), done.end(), offset_bytes) != done.end()) continue;
+                        done.push_back(offset_bytes);
+                        kernel_call_t call = { ws.in0, ws.in1, ws.out + offset_bytes, n, isa, skew };
+
+                        // Same result from one call of either mode, from the same input
+                        size_t out_bytes = n * first.elem_size;
+                        prepare_cell(first, call, split.partition, exec, placement);
+                        run_pipeline_unfused(stages, call, split, exec, sched);
+                        std::vector<char> expected(ws.out + offset_bytes, ws.out + offset_bytes + out_bytes);
+                        init_kernel_buffers(first, call, split.partition, exec);
+                        run_pipeline_fused(stages, call, split.partition, block_elems, exec);
+                        if (std::memcmp(expected.data(), ws.out + offset_bytes, out_bytes) != 0) {
+                            std::cerr << "❌ " << name << " " << elem_type_name(type) << ": fused and unfused results differ\n";
+                            return false;
+                        }
+
+                        measure_stats_t unfused_kernel, fused_kernel;
+                        init_kernel_buffers(first, call, split.partition, exec);
+                        measure_stats_t unfused = measure_cell(exec, sched, config,
+                            [&]() { return run_pipeline_unfused(stages, call, split, exec, sched); }, &unfused_kernel);
+                        double unfused_llc = llc_misses_per_run(exec, unfused.runs);
+                        init_kernel_buffers(first, call, split.partition, exec);
+                        measure_stats_t fused = measure_cell(exec, sched, config,
+                            [&]() { return run_pipeline_fused(stages, call, split.partition, block_elems, exec); }, &fused_kernel);
+                        double fused_llc = llc_misses_per_run(exec, fused.runs);
+                        bool significant = stats_differ(unfused, fused);
+
+                        std::cout << "🔗 " << name << " " << elem_type_name(type) << " " << n << " el"
+                                  << (size.level.empty() ? "" : " (" + size.level + ")") << ", " << num_threads
+                                  << " threads, " << partition_name(split.partition) << ", offset " << offset_bytes
+                                  << ": unfused " << unfused.median << " sec (" << unfused_bytes / 1e6 << " MB), fused "
+                                  << fused.median << " sec in " << block_bytes << " B blocks (" << fused_bytes / 1e6
+                                  << " MB, " << (unfused_bytes - fused_bytes) / 1e6 << " MB saved), "
+                                  << unfused.median / fused.median << "x" << (significant ? "" : " (within noise)");
+                        if (unfused_llc >= 0.0)
+                            std::cout << ", LLC misses/run " << unfused_llc << " -> " << fused_llc;
+                        std::cout << "\n";
+
+                        const char* modes[2] = { "unfused", "fused" };
+                        const measure_stats_t* times[2] = { &unfused, &fused };
+                        const measure_stats_t* kernel_times[2] = { &unfused_kernel, &fused_kernel };
+                        double bytes_moved[2] = { unfused_bytes, fused_bytes };
+                        double llc[2] = { unfused_llc, fused_llc };
+                        for (int m = 0; m < 2; ++m) {
+                            const measure_stats_t& time = *times[m];
+                            csv << name << "," << elem_type_name(type) << "," << size.level << "," << n << ","
+                                << num_threads << "," << offset_bytes << "," << partition_name(split.partition) << ","
+                                << modes[m] << "," << (m ? block_bytes : 0) << "," << time.median << "," << time.min << ","
+                                << time.p90 << "," << time.cv << "," << time.runs << "," << kernel_times[m]->median << ","
+                                << bytes_moved[m] << "," << bytes_moved[m] / time.median / 1e9 << ","
+                                << unfused.median / time.median << "," << (m ? significant : false) << ","
+                                << unfused_bytes - bytes_moved[m] << ",";
+                            if (llc[m] >= 0.0) csv << llc[m];
+                            csv << "," << exec_backend_name(exec.backend()) << "," << pin_policy_name(placement.pin) << ","
+                                << page_backend_name(used_page_backend()) << "\n";
+
+                            JsonRecord record;
+                            record.add("benchmark", "pipeline")
+                                  .add("pipeline", name)
+                                  .add("type", elem_type_name(type))
+                                  .add("elements", static_cast<long long>(n))
+                                  .add("threads", num_threads)
+                                  .add("offset", offset_bytes)
+                                  .add("partition", partition_name(split.partition))
+                                  .add("mode", modes[m])
+                                  .add("block_bytes", m ? block_bytes : 0)
+                                  .add("backend", exec_backend_name(exec.backend()))
+                                  .add("pin", pin_policy_name(placement.pin))
+                                  .add("pages", page_backend_name(used_page_backend()));
+                            if (!size.level.empty()) record.add("level", size.level);
+
+                            JsonRecord result;
+                            result.add("time", time)
+                                  .add("kernel_time", *kernel_times[m])
+                                  .add("bytes_moved", bytes_moved[m])
+                                  .add("bytes_saved", unfused_bytes - bytes_moved[m]);
+                            if (llc[m] >= 0.0) result.add("llc_misses", llc[m]);
+                            store_result(MEASUREMENTS_PATH, record, result);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Print the roofs of one executor and append them to roofline.csv
+void report_roofline(const roofline_t& roof, const ParallelExecutor& exec, const placement_t& placement,
+                     size_t array_bytes, std::ofstream& csv) {
+    std::cout << "🏠 Roofline, " << roof.threads << (roof.threads == 1 ? " thread" : " threads") << ": STREAM";
+    for (const stream_result_t& r : roof.stream) std::cout << " " << r.kernel << " " << r.gbps;
+    std::cout << " GB/s, peak " << roof.peak_gflops << " GFLOP/s (" << simd_isa_name(roof.isa) << "), ridge at "
+              << ridge_intensity(roof) << " flop/B\n";
+    csv << roof.threads << "," << exec_backend_name(exec.backend()) << "," << pin_policy_name(placement.pin) << ","
+        << array_bytes;
+    for (const stream_result_t& r : roof.stream) csv << "," << r.gbps;
+    csv << "," << roof.bandwidth_gbps << "," << roof.peak_gflops << "," << simd_isa_name(roof.isa) << ","
+        << ridge_intensity(roof) << "\n";
+}
+
+void print_kernels() {
+    std::cout << "🧰 Registered kernels:\n";
+    for (const kernel_desc_t& kernel : kernel_registry())
+        std::cout << "   " << kernel.name << " (" << elem_type_name(kernel.type) << "): " << kernel.description << "\n";
+}
+
+int main(int argc, char** argv) {
+    const run_metadata_t& run = begin_run(argc, argv);
+
+    // Capture system information if not already captured
+    if (system("test -f ../data/system_info.txt || ../scripts/capture_system_info.sh") != 0) {
+        std::cerr << "Warning: Could not capture system information\n";
+    }
+
+    std::vector<std::string> kernel_names = split_list("add,arith,arith_simd");
+    std::vector<std::string> type_names = split_list("float");
+    std::vector<std::string> thread_list;
+    std::vector<std::string> offset_list = split_list("0,4");
+    std::vector<std::string> size_list = split_list(DEFAULT_SIZE);
+    std::vector<std::string> partition_list = split_list("index");
+    std::vector<std::string> schedule_list;
+    std::vector<std::string> pipeline_list;
+    bool kernels_given = false;
+    size_t block_bytes = 0;
+    std::string results_path = RESULTS_PATH;
+    double skew = 8.0;
+    dim_t lines_per_chunk = 16;
+    simd_isa_t cpu_isa = detect_simd_isa();
+    simd_isa_t isa = cpu_isa;
+    exec_backend_t backend = BACKEND_OMP;
+    placement_t placement = { PIN_NONE, MEM_DEFAULT, 0 };
+    bool use_counters = false;
+    bool use_roofline = false;
+    uint64_t hitm_config = default_hitm_config();
+    track_backend_t track_backend = TRACK_OFF;
+    uint64_t track_period = 256;
+    uint64_t track_config = default_store_sample_config();
+    std::string trace_path;
+    measure_config_t config = default_measure_config();
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--list") == 0) { print_kernels(); return 0; }
+        if (std::strncmp(argv[i], "--kernels=", 10) == 0) {
+            kernel_names = split_list(argv[i] + 10);
+            kernels_given = true;
+            continue;
+        }
+        if (std::strncmp(argv[i], "--pipelines=", 12) == 0) { pipeline_list = split_list(argv[i] + 12); continue; }
+        if (std::strncmp(argv[i], "--block=", 8) == 0) {
+            if (!parse_count(argv[i] + 8, &block_bytes)) {
+                std::cerr << "Invalid block size '" << (argv[i] + 8) << "' (bytes with optional K/M/G)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--types=", 8) == 0) { type_names = split_list(argv[i] + 8); continue; }
+        if (std::strncmp(argv[i], "--threads=", 10) == 0) { thread_list = split_list(argv[i] + 10); continue; }
+        if (std::strncmp(argv[i], "--offsets=", 10) == 0) { offset_list = split_list(argv[i] + 10); continue; }
+        if (std::strncmp(argv[i], "--sizes=", 8) == 0) { size_list = split_list(argv[i] + 8); continue; }
+        if (std::strncmp(argv[i], "--partitions=", 13) == 0) { partition_list = split_list(argv[i] + 13); continue; }
+        if (std::strncmp(argv[i], "--schedules=", 12) == 0) { schedule_list = split_list(argv[i] + 12); continue; }
+        if (std::strncmp(argv[i], "--results=", 10) == 0) { results_path = argv[i] + 10; continue; }
+        if (std::strcmp(argv[i], "--sweep") == 0) { size_list = split_list("l1,l2,l3,dram"); continue; }
+        if (std::strncmp(argv[i], "--skew=", 7) == 0) {
+            skew = std::atof(argv[i] + 7);
+            if (skew < 0.0) {
+                std::cerr << "Invalid skew '" << (argv[i] + 7) << "' (must be >= 0)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--chunk-lines=", 14) == 0) {
+            long lines = std::atol(argv[i] + 14);
+            if (lines <= 0) {
+                std::cerr << "Invalid chunk size '" << (argv[i] + 14) << "' (cache lines per chunk, > 0)\n";
+                return 1;
+            }
+            lines_per_chunk = lines;
+            continue;
+        }
+        if (parse_measure_option(argv[i], &config)) continue;
+        if (std::strncmp(argv[i], "--isa=", 6) == 0) {
+            if (!parse_simd_isa(argv[i] + 6, &isa) || isa > cpu_isa) {
+                std::cerr << "Unsupported ISA '" << (argv[i] + 6) << "' (CPU supports up to "
+                          << simd_isa_name(cpu_isa) << ")\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--backend=", 10) == 0) {
+            if (!parse_exec_backend(argv[i] + 10, &backend)) {
+                std::cerr << "Unknown backend '" << (argv[i] + 10) << "' (use omp or pool)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strcmp(argv[i], "--counters") == 0) { use_counters = true; continue; }
+        if (std::strcmp(argv[i], "--roofline") == 0) { use_roofline = true; continue; }
+        if (std::strcmp(argv[i], "--track-writes") == 0) { track_backend = TRACK_PERF; continue; }
+        if (std::strncmp(argv[i], "--track-writes=", 15) == 0) {
+            if (!parse_track_backend(argv[i] + 15, &track_backend)) {
+                std::cerr << "Unknown write tracking '" << (argv[i] + 15) << "' (use software or perf)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--track-period=", 15) == 0) {
+            track_period = std::strtoull(argv[i] + 15, nullptr, 10);
+            if (track_period == 0) {
+                std::cerr << "Invalid sampling period '" << (argv[i] + 15) << "' (must be > 0)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--track-raw=", 12) == 0) {
+            track_config = std::strtoull(argv[i] + 12, nullptr, 0);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--trace") == 0) { trace_path = TRACE_PATH; continue; }
+        if (std::strncmp(argv[i], "--trace=", 8) == 0) { trace_path = argv[i] + 8; continue; }
+        if (std::strncmp(argv[i], "--hitm-raw=", 11) == 0) {
+            hitm_config = std::strtoull(argv[i] + 11, nullptr, 0);
+            continue;
+        }
+        if (std::strncmp(argv[i], "--pin=", 6) == 0) {
+            if (!parse_pin_policy(argv[i] + 6, &placement.pin)) {
+                std::cerr << "Unknown pin policy '" << (argv[i] + 6) << "' (use none, compact, scatter or smt)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--pages=", 8) == 0) {
+            page_backend_t pages;
+            if (!parse_page_backend(argv[i] + 8, &pages)) {
+                std::cerr << "Unknown page backend '" << (argv[i] + 8) << "' (use default, thp, 2m or 1g)\n";
+                return 1;
+            }
+            set_page_backend(pages);
+            continue;
+        }
+        if (std::strncmp(argv[i], "--mem=", 6) == 0) {
+            if (!parse_mem_policy(argv[i] + 6, &placement.mem, &placement.node)) {
+                std::cerr << "Unknown memory policy '" << (argv[i] + 6) << "' (use default, first-touch, interleave or bind:<node>)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (argv[i][0] == '-') {
+            std::cerr << "Unknown option '" << argv[i] << "'\n";
+            return 1;
+        }
+        // Old "<threads> <offset_bytes>" form: one thread count, aligned plus one offset
+        if (positional == 0) thread_list = split_list(argv[i]);
+        if (positional == 1) offset_list = { "0", argv[i] };
+        ++positional;
+    }
+
+    // Resolve the lists into the matrix; pipelines alone run no kernel cells
+    matrix_t matrix;
+    matrix.block_bytes = block_bytes;
+    if (!pipeline_list.empty() && !kernels_given) kernel_names.clear();
+    for (const std::string& name : kernel_names) {
+        if (name == "all") {
+            for (const kernel_desc_t& kernel : kernel_registry())
+                if (std::find(matrix.kernels.begin(), matrix.kernels.end(), kernel.name) == matrix.kernels.end())
+                    matrix.kernels.push_back(kernel.name);
+            continue;
+        }
+        if (!kernel_exists(name)) {
+            std::cerr << "Unknown kernel '" << name << "' (see --list)\n";
+            return 1;
+        }
+        matrix.kernels.push_back(name);
+    }
+    for (const std::string& text : pipeline_list) {
+        std::vector<std::string> stages;
+        size_t begin = 0;
+        for (size_t plus = text.find('+'); ; plus = text.find('+', begin)) {
+            stages.push_back(text.substr(begin, plus == std::string::npos ? std::string::npos : plus - begin));
+            if (plus == std::string::npos) break;
+            begin = plus + 1;
+        }
+        for (const std::string& stage : stages) {
+            if (!kernel_exists(stage)) {
+                std::cerr << "Unknown kernel '" << stage << "' in pipeline '" << text << "' (see --list)\n";
+                return 1;
+            }
+        }
+        matrix.pipelines.push_back(stages);
+    }
+    for (const std::string& name : type_names) {
+        elem_type_t type;
+        if (!parse_elem_type(name.c_str(), &type)) {
+            std::cerr << "Unknown element type '" << name << "' (use float, double, int8, uint16 or vec4)\n";
+            return 1;
+        }
+        matrix.types.push_back(type);
+    }
+    if (thread_list.empty()) thread_list.push_back(std::to_string(get_num_threads()));
+    for (const std::string& text : thread_list) {
+        int threads = std::atoi(text.c_str());
+        if (threads < 1) {
+            std::cerr << "Invalid thread count '" << text << "'\n";
+            return 1;
+        }
+        matrix.threads.push_back(threads);
+    }
+    for (const std::string& text : offset_list) {
+        char* end = nullptr;
+        long offset = std::strtol(text.c_str(), &end, 10);
+        if (*end != '\0' || offset < 0) {
+            std::cerr << "Invalid offset '" << text << "' (bytes, >= 0)\n";
+            return 1;
+        }
+        matrix.offsets.push_back(offset);
+    }
+    // Ascending, so offset 0, the baseline of vs_aligned, runs before the
+    // misaligned offsets whatever order they were given in
+    std::sort(matrix.offsets.begin(), matrix.offsets.end());
+    cache_info_t cache = query_cache_info();
+    for (const std::string& text : size_list) {
+        size_spec_t size = { "", 0, 0 };
+        for (const sweep_point_t& point : cache_sweep_points(cache)) {
+            std::string level = point.level;
+            std::transform(level.begin(), level.end(), level.begin(), ::tolower);
+            if (text == level) size = { point.level, point.bytes, 0 };
+        }
+        if (size.level.empty() && !parse_count(text, &size.elements)) {
+            std::cerr << "Invalid size '" << text << "' (elements with optional K/M/G, or l1, l2, l3, dram)\n";
+            return 1;
+        }
+        matrix.sizes.push_back(size);
+    }
+    for (const std::string& name : partition_list) {
+        partition_t partition;
+        if (!parse_partition(name.c_str(), &partition)) {
+            std::cerr << "Unknown partition '" << name << "' (use index or line)\n";
+            return 1;
+        }
+        matrix.splits.push_back({ partition, SCHED_STATIC, lines_per_chunk });
+    }
+    for (const std::string& name : schedule_list) {
+        schedule_t schedule;
+        if (!parse_schedule(name.c_str(), &schedule)) {
+            std::cerr << "Unknown schedule '" << name << "' (use static, dynamic, guided or steal)\n";
+            return 1;
+        }
+        matrix.splits.push_back({ PARTITION_CHUNKS, schedule, lines_per_chunk });
+    }
+
+    // An empty option ("--offsets=") leaves an empty list, which would run
+    // nothing or size the workspace from nothing
+    if (matrix.kernels.empty() && matrix.pipelines.empty()) {
+        std::cerr << "No kernels or pipelines given (see --list)\n";
+        return 1;
+    }
+    if (matrix.types.empty()) {
+        std::cerr << "No element types given (use float, double, int8, uint16 or vec4)\n";
+        return 1;
+    }
+    if (matrix.offsets.empty()) {
+        std::cerr << "No offsets given (bytes, >= 0)\n";
+        return 1;
+    }
+    if (matrix.sizes.empty()) {
+        std::cerr << "No sizes given (elements with optional K/M/G, or l1, l2, l3, dram)\n";
+        return 1;
+    }
+    if (matrix.splits.empty()) {
+        std::cerr << "No partitions or schedules given (use index or line, or a schedule)\n";
+        return 1;
+    }
+
+    // One workspace for the largest cell of the whole matrix
+    size_t max_offset = *std::max_element(matrix.offsets.begin(), matrix.offsets.end());
+    size_t bytes = 0;
+    for (elem_type_t type : matrix.types)
+        for (const size_spec_t& size : matrix.sizes)
+            for (const std::string& name : matrix.kernels)
+                if (const kernel_desc_t* kernel = find_kernel(name, type))
+                    bytes = std::max(bytes, size_elements(size, *kernel) * kernel->elem_size
+                                            + misalign_offset(max_offset, kernel->elem_size));
+    for (elem_type_t type : matrix.types)
+        for (const size_spec_t& size : matrix.sizes)
+            for (const std::vector<std::string>& stages : matrix.pipelines)
+                if (const kernel_desc_t* kernel = find_kernel(stages[0], type))
+                    bytes = std::max(bytes, size_elements(size, *kernel) * kernel->elem_size
+                                            + misalign_offset(max_offset, kernel->elem_size));
+
+    std::cout << "🧮 Benchmark Driver\n";
+    std::cout << "🔑 Run " << run.id << ", machine " << run.fingerprint << ", revision " << run.git_revision << "\n";
+    std::cout << "🧰 Kernels:";
+    for (const std::string& name : matrix.kernels) std::cout << " " << name;
+    if (!matrix.pipelines.empty()) {
+        std::cout << "\n🔗 Pipelines:";
+        for (const std::vector<std::string>& stages : matrix.pipelines) std::cout << " " << pipeline_name(stages);
+    }
+    std::cout << "\n🔢 Types:";
+    for (elem_type_t type : matrix.types) std::cout << " " << elem_type_name(type);
+    std::cout << "\n🧵 Threads:";
+    for (int threads : matrix.threads) std::cout << " " << threads;
+    std::cout << "\n📏 Offsets:";
+    for (size_t offset : matrix.offsets) std::cout << " " << offset;
+    std::cout << " bytes, sizes:";
+    for (const std::string& text : size_list) std::cout << " " << text;
+    std::cout << "\n📐 L1d " << cache.l1d_size << " B, L2 " << cache.l2_size << " B, L3 " << cache.l3_size << " B\n";
+    std::cout << "🚀 SIMD kernels: " << simd_isa_name(isa) << "\n";
+    std::cout << "🎯 Target: 95% CI within " << config.target_ci * 100.0 << "% of the mean, "
+              << config.min_runs << "-" << config.max_runs << " runs, " << config.time_budget << " s budget\n";
+    std::cout << "📌 Pinning: " << pin_policy_name(placement.pin) << ", memory: " << mem_policy_name(placement.mem);
+    if (placement.mem == MEM_BIND) std::cout << " node " << placement.node;
+    std::cout << "\n";
+
+    std::ofstream csv;
+    if (!open_csv(csv, results_path,
+                  "kernel,type,elem_size,level,elements,bytes,threads,offset,partition,schedule,chunk_lines,isa,backend,pin,mem,pages"
+                  ",time,min,p90,p99,cv,runs,converged,kernel_time,gbps,vs_aligned,vs_aligned_significant,shared_lines,contended_bytes"
+                  ",imbalance,steals_per_run,cycles,instructions,l1d_misses,llc_misses,hitm,tracked_shared_lines,tracking_overhead"
+                  ",intensity,gflops,attainable_gflops,roofline_bound,roofline_efficiency"
+                  ",trace_imbalance,straggler,start_spread_us,finish_spread_us")) {
+        std::cerr << "Cannot write results '" << results_path << "'\n";
+        return 1;
+    }
+    std::ofstream pipeline_csv;
+    if (!matrix.pipelines.empty() &&
+        !open_csv(pipeline_csv, PIPELINE_PATH,
+                  "pipeline,type,level,elements,threads,offset,partition,mode,block_bytes,time,min,p90,cv,runs"
+                  ",kernel_time,bytes_moved,gbps,speedup_vs_unfused,speedup_significant,bytes_saved,llc_misses"
+                  ",backend,pin,pages")) {
+        std::cerr << "Cannot write results '" << PIPELINE_PATH << "'\n";
+        return 1;
+    }
+    std::ofstream roofline_csv;
+    size_t stream_bytes = std::max<size_t>(4 * cache.l3_size, size_t(32) << 20);
+    if (use_roofline) {
+        if (!open_csv(roofline_csv, ROOFLINE_PATH,
+                      "threads,backend,pin,array_bytes,copy_gbps,scale_gbps,add_gbps,triad_gbps,bandwidth_gbps"
+                      ",peak_gflops,isa,ridge_intensity")) {
+            std::cerr << "Cannot write results '" << ROOFLINE_PATH << "'\n";
+            return 1;
+        }
+
+        // The single-thread roofs, also when 1 is not in the matrix
+        if (std::find(matrix.threads.begin(), matrix.threads.end(), 1) == matrix.threads.end()) {
+            ParallelExecutor single(backend, 1, pin_policy_cpus(placement.pin, 1));
+            report_roofline(measure_roofline(single, stream_bytes, config, isa), single, placement, stream_bytes, roofline_csv);
+        }
+    }
+    ChromeTraceWriter trace;
+    if (!trace_path.empty()) {
+        if (!trace.open(trace_path)) {
+            std::cerr << "Cannot write trace '" << trace_path << "'\n";
+            return 1;
+        }
+        const timeline_clock_t& clock = timeline_calibrate();
+        std::cout << "⏱️  Timeline: " << timeline_source_name(clock.source) << " (" << clock.ticks_per_ns
+                  << " ticks/ns), " << TRACE_RUNS << " traced runs per cell\n";
+    }
+    std::ofstream thread_csv;
+    if (use_counters &&
+        !open_csv(thread_csv, PERF_THREADS_PATH,
+                  "threads,offset,kernel,buffer,work_id,cycles,instructions,l1d_misses,llc_misses,hitm")) {
+        std::cerr << "Cannot write results '" << PERF_THREADS_PATH << "'\n";
+        return 1;
+    }
+
+    // Temporaries touched by the main thread follow the policy too; the
+    // workspace itself is bound explicitly when it is placed.
+    set_thread_mem_policy(placement.mem, placement.node);
+    workspace_t ws = allocate_workspace(bytes);
+    print_page_report("Workspace", ws.out, ws.bytes);
+    place_workspace(ws, placement);
+
+    for (int num_threads : matrix.threads) {
+        ParallelExecutor exec(backend, num_threads, pin_policy_cpus(placement.pin, num_threads));
+        std::cout << "\n🔀 " << num_threads << " threads, " << exec_backend_name(backend) << " backend (empty dispatch "
+                  << exec.measure_dispatch(1000) * 1e6 << " us)\n";
+
+        // Hardware counters around each thread's kernel call, per run
+        PerfCounters perf(num_threads, hitm_config);
+        if (use_counters) {
+            if (exec.attach_counters(&perf)) {
+                std::cout << "📟 Counters:";
+                for (int e = 0; e < PERF_NUM_EVENTS; ++e)
+                    if (perf.available(static_cast<perf_event_id_t>(e)))
+                        std::cout << " " << PerfCounters::event_name(static_cast<perf_event_id_t>(e));
+                std::cout << "\n";
+            }
+            if (!perf.error().empty())
+                std::cout << "📟 Unavailable: " << perf.error() << "\n";
+        }
+
+        // Sampled write tracking in extra runs after each measurement
+        WriteTracker tracker(num_threads, track_backend, track_period, TRACK_SAMPLES, CACHE_LINE_SIZE, track_config);
+        if (track_backend != TRACK_OFF) {
+            bool attached = exec.attach_tracker(&tracker);
+            if (!attached)
+                std::cout << "🔎 Write tracking unavailable: " << tracker.error() << "\n";
+            else if (tracker.backend() != track_backend)
+                std::cout << "🔎 Write tracking: " << track_backend_name(tracker.backend()) << " ("
+                          << track_backend_name(track_backend) << " unavailable: " << tracker.error() << ")\n";
+            else
+                std::cout << "🔎 Write tracking: " << track_backend_name(tracker.backend()) << ", 1 in "
+                          << track_period << " writes\n";
+        }
+
+        // Per-thread timeline in extra runs after each measurement
+        Timeline timeline(num_threads, TRACE_EVENTS);
+        if (trace.is_open()) exec.attach_timeline(&timeline);
+
+        // Bandwidth and compute roofs of this executor
+        roofline_t roof = {};
+        if (use_roofline) {
+            roof = measure_roofline(exec, stream_bytes, config, isa);
+            report_roofline(roof, exec, placement, stream_bytes, roofline_csv);
+        }
+
+        run_thread_count(matrix, exec, ws, placement, config, isa, skew, use_roofline ? &roof : nullptr, trace, csv,
+                         thread_csv);
+        if (!run_pipelines(matrix, exec, ws, placement, config, isa, skew, cache, pipeline_csv)) return 1;
+    }
+
+    free_workspace(ws);
+    std::cout << "\n📊 Results appended to " << results_path << "\n";
+    if (!matrix.pipelines.empty()) std::cout << "📊 Pipeline results appended to " << PIPELINE_PATH << "\n";
+    if (trace.is_open()) {
+        trace.close();
+        std::cout << "⏱️  Trace written to " << trace_path << " (open in chrome://tracing or ui.perfetto.dev)\n";
+    }
+    return 0;
+}
+// g++ -fopenmp -O3 -march=native -std=c++17 benchmark_driver.cpp benchmark_common.cpp kernel_registry.cpp thread_utils.cpp cache_info.cpp simd_kernels.cpp thread_pool.cpp numa_placement.cpp perf_counters.cpp write_tracker.cpp timeline.cpp measurement.cpp result_store.cpp false_sharing.cpp element_types.cpp work_scheduler.cpp huge_pages.cpp roofline.cpp -o benchmark_driver
+// ./benchmark_driver --list
+// ./benchmark_driver --pipelines=add+arith_simd --threads=4 --sizes=16M [--block=64K]
+// ./benchmark_driver --kernels=add,arith --threads=2,4,8 --offsets=0,4,8,16,32,64 --sizes=1M,l3 [--types=float,double] [--partitions=index,line] [--schedules=static,steal] [--trace[=path]]
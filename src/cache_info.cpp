@@ -0,0 +1,78 @@
+#include "cache_info.h"
+
+#include <fstream>
+#include <unistd.h>
+
+#define DEFAULT_LINE_SIZE 64
+#define DEFAULT_L1D_SIZE  (32 * 1024)
+#define DEFAULT_L2_SIZE   (1024 * 1024)
+#define DEFAULT_L3_SIZE   (32 * 1024 * 1024)
+
+// Read "<n>K" / "<n>M" style sizes from /sys/devices/system/cpu/cpu0/cache
+static std::size_t sysfs_cache_size(int level, const char* type)
+{
+	for (int index = 0; index < 8; ++index) {
+		std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+		std::ifstream level_file(dir + "level");
+		std::ifstream type_file(dir + "type");
+		std::ifstream size_file(dir + "size");
+		if (!level_file || !type_file || !size_file) break;
+
+		int         l = 0;
+		std::string t, s;
+		level_file >> l;
+		type_file >> t;
+		size_file >> s;
+		if (l != level || (t != type && t != "Unified") || s.empty()) continue;
+
+		std::size_t value = std::stoul(s);
+		switch (s.back()) {
+			case 'K': value *= 1024; break;
+			case 'M': value *= 1024 * 1024; break;
+			case 'G': value *= 1024 * 1024 * 1024; break;
+		}
+		return value;
+	}
+	return 0;
+}
+
+static std::size_t sysconf_size(int name)
+{
+	long value = sysconf(name);
+	return value > 0 ? static_cast<std::size_t>(value) : 0;
+}
+
+cache_info_t query_cache_info()
+{
+	cache_info_t info;
+
+	info.line_size = sysconf_size(_SC_LEVEL1_DCACHE_LINESIZE);
+	info.l1d_size  = sysconf_size(_SC_LEVEL1_DCACHE_SIZE);
+	info.l2_size   = sysconf_size(_SC_LEVEL2_CACHE_SIZE);
+	info.l3_size   = sysconf_size(_SC_LEVEL3_CACHE_SIZE);
+
+	if (info.l1d_size == 0) info.l1d_size = sysfs_cache_size(1, "Data");
+	if (info.l2_size  == 0) info.l2_size  = sysfs_cache_size(2, "Unified");
+	if (info.l3_size  == 0) info.l3_size  = sysfs_cache_size(3, "Unified");
+
+	if (info.line_size == 0) info.line_size = DEFAULT_LINE_SIZE;
+	if (info.l1d_size  == 0) info.l1d_size  = DEFAULT_L1D_SIZE;
+	if (info.l2_size   == 0) info.l2_size   = DEFAULT_L2_SIZE;
+	// Some parts have no L3; treat L2 as the last level in that case.
+	if (info.l3_size   == 0) info.l3_size   = info.l2_size > DEFAULT_L3_SIZE ? info.l2_size : DEFAULT_L3_SIZE;
+
+	return info;
+}
+
+std::vector<sweep_point_t> cache_sweep_points(const cache_info_t& info)
+{
+	// Use half of each level so that code, stack and the other arrays of
+	// the kernel do not evict the working set. The DRAM point is four
+	// times the last level cache so that nothing survives between runs.
+	std::vector<sweep_point_t> points;
+	points.push_back({"L1",   info.l1d_size / 2});
+	points.push_back({"L2",   info.l2_size  / 2});
+	points.push_back({"L3",   info.l3_size  / 2});
+	points.push_back({"DRAM", info.l3_size  * 4});
+	return points;
+}
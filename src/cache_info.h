@@ -0,0 +1,33 @@
+#ifndef CACHE_INFO_H
+#define CACHE_INFO_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Data cache geometry of the host, in bytes
+struct cache_info_t
+{
+	std::size_t line_size;
+	std::size_t l1d_size;
+	std::size_t l2_size;
+	std::size_t l3_size;
+};
+
+// One working-set size of a cache sweep
+struct sweep_point_t
+{
+	std::string level;   // "L1", "L2", "L3" or "DRAM"
+	std::size_t bytes;   // total working set touched by the kernel
+};
+
+// Query the cache sizes of the host. Uses the same getconf values that
+// capture_system_info.sh records, falling back to sysfs and then to
+// conservative defaults when a level is not reported.
+cache_info_t query_cache_info();
+
+// Working-set sizes that fit in L1, L2 and L3 with some headroom, plus
+// one that spills well past the last level cache into DRAM.
+std::vector<sweep_point_t> cache_sweep_points(const cache_info_t& info);
+
+#endif // CACHE_INFO_H
@@ -0,0 +1,179 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "measurement.h"
+#include "result_store.h"
+#include "benchmark_common.h"
+
+#define DEFAULT_METRIC "time"
+#define DEFAULT_THRESHOLD 0.05   // Smallest slowdown of the mean that counts, as a fraction
+
+// One side of the comparison: a store and which of its records to use
+struct result_set_t {
+    std::string path;
+    std::string selector;   // run id or git revision prefix, "all", or empty for the last run
+    std::vector<stored_result_t> results;
+    std::map<std::string, const stored_result_t*> by_config;   // the last record of every configuration
+    std::vector<std::string> fingerprints;
+    std::vector<std::string> revisions;
+};
+
+static bool starts_with(const std::string& text, const std::string& prefix) {
+    return !prefix.empty() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+static void add_unique(std::vector<std::string>& list, const std::string& value) {
+    if (std::find(list.begin(), list.end(), value) == list.end()) list.push_back(value);
+}
+
+// Load "path[@selector]" and index the selected records by configuration
+static bool load_set(const char* arg, const std::vector<std::string>& ignore, result_set_t* set) {
+    std::string text = arg;
+    std::size_t at = text.rfind('@');
+    set->path = text.substr(0, at);
+    if (at != std::string::npos) set->selector = text.substr(at + 1);
+
+    std::size_t skipped = 0;
+    if (!load_results(set->path.c_str(), &set->results, &skipped)) {
+        std::cerr << "Cannot read result store '" << set->path << "'\n";
+        return false;
+    }
+    if (skipped) std::cerr << "⚠️  " << set->path << ": skipped " << skipped << " malformed lines\n";
+
+    std::string last_run = set->results.empty() ? std::string() : set->results.back().run_id;
+    for (const stored_result_t& result : set->results) {
+        bool selected;
+        if (set->selector.empty()) selected = result.run_id == last_run;
+        else if (set->selector == "all") selected = true;
+        else selected = starts_with(result.run_id, set->selector) || starts_with(result.git_revision, set->selector);
+        if (!selected) continue;
+        set->by_config[result_config_key(result.record, ignore)] = &result;
+        add_unique(set->fingerprints, result.fingerprint.empty() ? "unknown" : result.fingerprint);
+        add_unique(set->revisions, result.git_revision.empty() ? "unknown" : result.git_revision);
+    }
+    if (set->by_config.empty()) {
+        std::cerr << "No records in '" << set->path << "' match '" << set->selector << "'\n";
+        return false;
+    }
+    return true;
+}
+
+static std::string join(const std::vector<std::string>& list) {
+    std::string text;
+    for (const std::string& item : list) text += (text.empty() ? "" : ", ") + item;
+    return text;
+}
+
+static void print_run(const run_metadata_t& run) {
+    std::cout << "🖥️  " << run.host << ": " << run.cpu_model << ", " << run.cpus << " CPUs, " << run.numa_nodes
+              << " NUMA nodes, " << run.caches << ", " << run.memory_kb / 1024 << " MiB, " << run.kernel << "\n";
+    std::cout << "🔑 Fingerprint " << run.fingerprint << "\n";
+    std::cout << "🔧 " << run.compiler << " (" << run.flags << "), revision " << run.git_revision << "\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> sets;
+    std::string metric = DEFAULT_METRIC;
+    double threshold = DEFAULT_THRESHOLD;
+    std::vector<std::string> ignore;
+    bool show_all = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--fingerprint") == 0) {
+            print_run(begin_run(argc, argv));
+            return 0;
+        }
+        if (std::strcmp(argv[i], "--all") == 0) {
+            show_all = true;
+            continue;
+        }
+        if (std::strncmp(argv[i], "--metric=", 9) == 0) {
+            metric = argv[i] + 9;
+            continue;
+        }
+        if (std::strncmp(argv[i], "--threshold=", 12) == 0) {
+            threshold = std::atof(argv[i] + 12);
+            if (threshold < 0.0) {
+                std::cerr << "Invalid threshold '" << (argv[i] + 12) << "' (must be >= 0)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--ignore=", 9) == 0) {
+            for (const std::string& field : split_list(argv[i] + 9)) ignore.push_back(field);
+            continue;
+        }
+        if (argv[i][0] == '-' && argv[i][1] == '-') {
+            std::cerr << "Unknown option '" << argv[i] << "'\n";
+            return 1;
+        }
+        sets.push_back(argv[i]);
+    }
+    if (sets.size() != 2) {
+        std::cerr << "Usage: compare_results <base>[@run|revision|all] <new>[@run|revision|all] "
+                     "[--metric=time] [--threshold=0.05] [--ignore=field,...] [--all]\n";
+        return 1;
+    }
+
+    result_set_t base, next;
+    if (!load_set(sets[0], ignore, &base) || !load_set(sets[1], ignore, &next)) return 1;
+
+    std::cout << "📂 Base: " << base.by_config.size() << " configurations, revision " << join(base.revisions)
+              << ", machine " << join(base.fingerprints) << "\n";
+    std::cout << "📂 New:  " << next.by_config.size() << " configurations, revision " << join(next.revisions)
+              << ", machine " << join(next.fingerprints) << "\n";
+    if (base.fingerprints != next.fingerprints)
+        std::cout << "⚠️  The sets come from different machines; differences include the hardware\n";
+
+    int matched = 0, regressions = 0, improvements = 0, missing_metric = 0;
+    for (const auto& entry : base.by_config) {
+        auto found = next.by_config.find(entry.first);
+        if (found == next.by_config.end()) continue;
+        ++matched;
+        const json_value_t* old_value = result_field(entry.second->record, metric.c_str());
+        const json_value_t* new_value = result_field(found->second->record, metric.c_str());
+        measure_stats_t old_stats, new_stats;
+        if (!old_value || !new_value || !stats_from_json(*old_value, &old_stats) ||
+            !stats_from_json(*new_value, &new_stats)) {
+            ++missing_metric;
+            continue;
+        }
+
+        // Slower by more than the threshold and outside both confidence
+        // intervals, so neither noise nor a tiny shift fails the gate
+        double change = new_stats.mean / old_stats.mean - 1.0;
+        bool significant = stats_differ(old_stats, new_stats);
+        bool regressed = significant && change > threshold;
+        bool improved = significant && change < -threshold;
+        if (regressed) ++regressions;
+        if (improved) ++improvements;
+        if (!regressed && !improved && !show_all) continue;
+
+        const char* mark = regressed ? "❌" : improved ? "✅" : "  ";
+        std::cout << mark << " " << entry.first << ": " << old_stats.mean << " -> " << new_stats.mean << " sec ("
+                  << (change >= 0 ? "+" : "") << change * 100.0 << "%, CI ±" << old_stats.ci95 << " / ±"
+                  << new_stats.ci95 << (significant ? "" : ", within noise") << ")\n";
+    }
+
+    std::cout << "📊 " << matched << " matched, " << regressions << " regressions, " << improvements
+              << " improvements, " << base.by_config.size() - matched << " only in base, "
+              << next.by_config.size() - matched << " only in new";
+    if (missing_metric) std::cout << ", " << missing_metric << " without '" << metric << "'";
+    std::cout << "\n";
+    if (matched == 0) {
+        std::cerr << "No configuration appears in both sets\n";
+        return 1;
+    }
+    if (regressions) {
+        std::cout << "❌ " << regressions << " configurations regressed by more than " << threshold * 100.0 << "%\n";
+        return 1;
+    }
+    std::cout << "✅ No regressions beyond " << threshold * 100.0 << "%\n";
+    return 0;
+}
+// g++ -O2 -std=c++17 -o compare_results compare_results.cpp result_store.cpp measurement.cpp benchmark_common.cpp cache_info.cpp numa_placement.cpp thread_utils.cpp
+// ./compare_results ../data/measurements.jsonl@<base revision> ../data/measurements.jsonl [--metric=kernel_time] [--threshold=0.05] [--ignore=elements] [--all]
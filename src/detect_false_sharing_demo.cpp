@@ -1,14 +1,14 @@
 #include <iostream>
 #include <vector>
 #include <utility>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <cstdio>
+#include "false_sharing.h"
 
 constexpr int CACHE_LINE_SIZE = 64; // typical x86 cache line size
 
-using dim_t = std::size_t;
-
 // Generate index ranges for each thread
 std::vector<std::pair<dim_t, dim_t>> generate_thread_ranges(dim_t total_size, int num_threads) {
     std::vector<std::pair<dim_t, dim_t>> ranges(num_threads);
@@ -24,50 +24,21 @@ std::vector<std::pair<dim_t, dim_t>> generate_thread_ranges(dim_t total_size, in
     return ranges;
 }
 
-// Detect false sharing by checking cache line overlap
-bool detect_false_sharing(const std::vector<std::pair<dim_t, dim_t>>& thread_ranges,
-                          const float* data_address, int num_threads) {
-    if (thread_ranges.size() < 2) return false;
-
-    uintptr_t base_addr = reinterpret_cast<uintptr_t>(data_address);
-
-    for (size_t i = 0; i < thread_ranges.size(); ++i) {
-        for (size_t j = i + 1; j < thread_ranges.size(); ++j) {
-            dim_t start1 = thread_ranges[i].first;
-            dim_t end1   = thread_ranges[i].second;
-            dim_t start2 = thread_ranges[j].first;
-            dim_t end2   = thread_ranges[j].second;
-
-            uintptr_t addr1_start = base_addr + start1 * sizeof(float);
-            uintptr_t addr1_end   = base_addr + (end1 - 1) * sizeof(float);
-            uintptr_t addr2_start = base_addr + start2 * sizeof(float);
-            uintptr_t addr2_end   = base_addr + (end2 - 1) * sizeof(float);
-
-            int cl1_start = addr1_start / CACHE_LINE_SIZE;
-            int cl1_end   = addr1_end   / CACHE_LINE_SIZE;
-            int cl2_start = addr2_start / CACHE_LINE_SIZE;
-            int cl2_end   = addr2_end   / CACHE_LINE_SIZE;
-
-            bool overlap = !(cl1_end < cl2_start || cl2_end < cl1_start);
-            if (overlap) {
-                printf("⚠️  False sharing detected between threads %zu and %zu!\n", i, j);
-                printf("    Thread %zu: cache lines %d-%d\n", i, cl1_start, cl1_end);
-                printf("    Thread %zu: cache lines %d-%d\n", j, cl2_start, cl2_end);
-                return true;
-            }
-        }
-    }
-
-    printf("✅ No false sharing detected - threads access separate cache lines\n");
-    return false;
+// Blocked writes of elem_size-byte elements, one contiguous range per thread
+std::vector<access_pattern_t> blocked_accesses(const void* data, size_t elem_size, dim_t n, int num_threads) {
+    std::vector<access_pattern_t> accesses;
+    auto ranges = generate_thread_ranges(n, num_threads);
+    for (int i = 0; i < num_threads; ++i)
+        accesses.push_back(contiguous_access(i, data, elem_size, ranges[i].first, ranges[i].second, true));
+    return accesses;
 }
 
-int main() {
+int main(int argc, char** argv) {
     const int num_threads = 4;
     const int total_elements = 256;
 
     // Allocate buffer
-    float* buffer = new float[total_elements];
+    float* buffer = new float[total_elements + CACHE_LINE_SIZE / sizeof(float)];
 
     // Simulate a misaligned pointer to force false sharing
     float* misaligned = reinterpret_cast<float*>(reinterpret_cast<char*>(buffer) + 32);
@@ -75,14 +46,44 @@ int main() {
     std::cout << "🔍 Checking false sharing with " << num_threads << " threads on "
               << total_elements << " float elements\n";
 
-    // Generate thread index ranges
-    auto thread_ranges = generate_thread_ranges(total_elements, num_threads);
-
-    // Run detection
-    detect_false_sharing(thread_ranges, misaligned, num_threads);
-
+    // Blocked ranges: only the lines at the range boundaries are shared
+    std::cout << "\n📦 Blocked, 32-byte offset:\n";
+    print_false_sharing_report(analyze_false_sharing(blocked_accesses(misaligned, sizeof(float), total_elements, num_threads),
+                                                     CACHE_LINE_SIZE));
+
+    // Cyclic distribution as in vector_add_interleaved(): every line is
+    // written by all threads
+    std::cout << "\n🔀 Interleaved (C[i] written by thread i % " << num_threads << "), A and B read:\n";
+    float* A = new float[total_elements];
+    float* B = new float[total_elements];
+    std::vector<access_pattern_t> interleaved;
+    for (int i = 0; i < num_threads; ++i) {
+        interleaved.push_back(strided_access(i, A, sizeof(float), i, total_elements, num_threads, false));
+        interleaved.push_back(strided_access(i, B, sizeof(float), i, total_elements, num_threads, false));
+        interleaved.push_back(strided_access(i, buffer, sizeof(float), i, total_elements, num_threads, true));
+    }
+    print_false_sharing_report(analyze_false_sharing(interleaved, CACHE_LINE_SIZE), 4);
+
+    // 24-byte elements straddle line boundaries even from an aligned base
+    std::cout << "\n📐 Blocked, 24-byte elements:\n";
+    print_false_sharing_report(analyze_false_sharing(blocked_accesses(buffer, 24, 42, num_threads), CACHE_LINE_SIZE));
+
+    // Scale check: many threads over a large misaligned array
+    int many_threads = argc > 1 ? std::atoi(argv[1]) : 256;
+    dim_t large_n = 1 << 26;
+    auto start = std::chrono::steady_clock::now();
+    false_sharing_report_t report = analyze_false_sharing(
+        blocked_accesses(reinterpret_cast<const void*>(uintptr_t(1) << 40 | 4), sizeof(float), large_n, many_threads),
+        CACHE_LINE_SIZE);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "\n🧵 " << many_threads << " threads over " << large_n << " floats (analysis "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms):\n";
+    print_false_sharing_report(report, 4);
+
+    delete[] A;
+    delete[] B;
     delete[] buffer;
     return 0;
 }
-// g++ -O2 -std=c++17 detect_false_sharing_demo.cpp -o detect_false_sharing_demo
-// ./detect_false_sharing_demo
+// g++ -O2 -std=c++17 detect_false_sharing_demo.cpp false_sharing.cpp -o detect_false_sharing_demo
+// ./detect_false_sharing_demo [threads]
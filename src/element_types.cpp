@@ -0,0 +1,25 @@
+#include "element_types.h"
+
+#include <cstring>
+
+bool parse_elem_type(const char* name, elem_type_t* type)
+{
+	for (int i = ELEM_FLOAT; i <= ELEM_VEC4; ++i) {
+		if (std::strcmp(name, elem_type_name(static_cast<elem_type_t>(i))) == 0) {
+			*type = static_cast<elem_type_t>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* elem_type_name(elem_type_t type)
+{
+	switch (type) {
+		case ELEM_DOUBLE: return "double";
+		case ELEM_INT8:   return "int8";
+		case ELEM_UINT16: return "uint16";
+		case ELEM_VEC4:   return "vec4";
+		default:          return "float";
+	}
+}
@@ -0,0 +1,91 @@
+#ifndef ELEMENT_TYPES_H
+#define ELEMENT_TYPES_H
+
+#include <cstddef>
+#include <cstdint>
+#include "thread_utils.h"
+#include "huge_pages.h"
+
+// 16-byte record, e.g. a packed xyzw position
+struct vec4_t
+{
+	float x, y, z, w;
+};
+
+inline vec4_t operator+(const vec4_t& a, const vec4_t& b)
+{
+	return { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w };
+}
+
+// Element types the benchmarks can be instantiated for
+enum elem_type_t
+{
+	ELEM_FLOAT = 0,
+	ELEM_DOUBLE,
+	ELEM_INT8,     // quantized data, 64 per line
+	ELEM_UINT16,
+	ELEM_VEC4      // 16-byte struct, 4 per line
+};
+
+// Parse "float", "double", "int8", "uint16" or "vec4"; returns false on unknown names
+bool parse_elem_type(const char* name, elem_type_t* type);
+
+const char* elem_type_name(elem_type_t type);
+
+// Compile-time properties of each element type. value(v) converts a small
+// fill value; sums of such values stay exact in every type.
+template <typename T> struct elem_traits;
+
+template <> struct elem_traits<float>
+{
+	static constexpr elem_type_t type = ELEM_FLOAT;
+	static float value(int v) { return static_cast<float>(v); }
+};
+
+template <> struct elem_traits<double>
+{
+	static constexpr elem_type_t type = ELEM_DOUBLE;
+	static double value(int v) { return static_cast<double>(v); }
+};
+
+template <> struct elem_traits<int8_t>
+{
+	static constexpr elem_type_t type = ELEM_INT8;
+	static int8_t value(int v) { return static_cast<int8_t>(v); }
+};
+
+template <> struct elem_traits<uint16_t>
+{
+	static constexpr elem_type_t type = ELEM_UINT16;
+	static uint16_t value(int v) { return static_cast<uint16_t>(v); }
+};
+
+template <> struct elem_traits<vec4_t>
+{
+	static constexpr elem_type_t type = ELEM_VEC4;
+	static vec4_t value(int v) { float f = static_cast<float>(v); return { f, f, f, f }; }
+};
+
+// Buffer of count elements starting on a cache line, from the page
+// backend selected with set_page_backend()
+template <typename T = float>
+T* allocate_aligned_buffer(std::size_t count)
+{
+	return static_cast<T*>(allocate_pages(count * sizeof(T)));
+}
+
+template <typename T>
+void free_aligned_buffer(T* ptr)
+{
+	free_pages(ptr);
+}
+
+// Smallest offset >= offset_bytes that is a whole number of elem_size-byte
+// elements, so that, like the float buffers, every element still lies
+// within one cache line and only the partition boundaries can be shared
+constexpr std::size_t misalign_offset(std::size_t offset_bytes, std::size_t elem_size)
+{
+	return (offset_bytes + elem_size - 1) / elem_size * elem_size;
+}
+
+#endif // ELEMENT_TYPES_H
@@ -0,0 +1,172 @@
+#include "false_sharing.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <set>
+
+// Lines [first, last] touched by one access pattern. Dense patterns (at
+// most one line between consecutive elements) touch every line of their
+// span and get one interval; sparser ones get one interval per element.
+struct line_interval_t
+{
+	uintptr_t first;
+	uintptr_t last;
+	int       access;
+	bool      single;   // one element of a sparse pattern
+};
+
+struct sweep_event_t
+{
+	uintptr_t pos;
+	int       interval;
+	bool      begin;
+};
+
+access_pattern_t contiguous_access(int thread, const void* base, std::size_t elem_size,
+                                   dim_t start, dim_t end, bool write)
+{
+	return strided_access(thread, base, elem_size, start, end, 1, write);
+}
+
+access_pattern_t strided_access(int thread, const void* base, std::size_t elem_size,
+                                dim_t start, dim_t end, dim_t stride, bool write)
+{
+	access_pattern_t access;
+	access.thread    = thread;
+	access.base      = base;
+	access.elem_size = elem_size;
+	access.start     = start;
+	access.end       = end;
+	access.stride    = stride ? stride : 1;
+	access.write     = write;
+	return access;
+}
+
+static dim_t element_count(const access_pattern_t& a)
+{
+	return a.end > a.start ? (a.end - a.start + a.stride - 1) / a.stride : 0;
+}
+
+static uintptr_t first_address(const access_pattern_t& a)
+{
+	return reinterpret_cast<uintptr_t>(a.base) + a.start * a.elem_size;
+}
+
+// Bytes of the elements of a dense pattern that start in [lo, hi)
+static std::size_t dense_bytes(const access_pattern_t& a, uintptr_t lo, uintptr_t hi)
+{
+	uintptr_t first = first_address(a);
+	uintptr_t step  = a.stride * a.elem_size;
+	dim_t     count = element_count(a);
+	if (hi <= first) return 0;
+
+	dim_t k_lo = lo > first ? (lo - first + step - 1) / step : 0;
+	dim_t k_hi = (hi - 1 - first) / step;
+	if (k_hi >= count) k_hi = count - 1;
+	return k_lo <= k_hi ? (k_hi - k_lo + 1) * a.elem_size : 0;
+}
+
+false_sharing_report_t analyze_false_sharing(const std::vector<access_pattern_t>& accesses,
+                                             std::size_t line_size)
+{
+	false_sharing_report_t report;
+	report.line_size   = line_size;
+	report.total_lines = 0;
+	report.total_bytes = 0;
+	report.max_threads = 0;
+
+	std::vector<line_interval_t> intervals;
+	for (std::size_t i = 0; i < accesses.size(); ++i) {
+		const access_pattern_t& a = accesses[i];
+		dim_t count = element_count(a);
+		if (count == 0 || a.elem_size == 0) continue;
+
+		uintptr_t first = first_address(a);
+		uintptr_t step  = a.stride * a.elem_size;
+		if (step <= line_size) {
+			uintptr_t last_byte = first + (count - 1) * step + a.elem_size - 1;
+			intervals.push_back({ first / line_size, last_byte / line_size, static_cast<int>(i), false });
+			continue;
+		}
+		for (dim_t k = 0; k < count; ++k) {
+			uintptr_t addr = first + k * step;
+			intervals.push_back({ addr / line_size, (addr + a.elem_size - 1) / line_size, static_cast<int>(i), true });
+		}
+	}
+
+	std::vector<sweep_event_t> events;
+	events.reserve(2 * intervals.size());
+	for (std::size_t i = 0; i < intervals.size(); ++i) {
+		events.push_back({ intervals[i].first,    static_cast<int>(i), true });
+		events.push_back({ intervals[i].last + 1, static_cast<int>(i), false });
+	}
+	std::sort(events.begin(), events.end(),
+	          [](const sweep_event_t& x, const sweep_event_t& y) { return x.pos < y.pos; });
+
+	// Between two consecutive event positions the set of active intervals,
+	// and therefore the set of threads, is constant
+	std::set<int>      active;
+	std::map<int, int> threads;   // thread -> active intervals
+	std::map<int, int> writers;   // thread -> active writing intervals
+	for (std::size_t e = 0; e < events.size(); ) {
+		uintptr_t pos = events[e].pos;
+		for (; e < events.size() && events[e].pos == pos; ++e) {
+			int i = events[e].interval;
+			const access_pattern_t& a = accesses[intervals[i].access];
+			int delta = events[e].begin ? 1 : -1;
+			if (events[e].begin) active.insert(i); else active.erase(i);
+			if ((threads[a.thread] += delta) == 0) threads.erase(a.thread);
+			if (a.write && (writers[a.thread] += delta) == 0) writers.erase(a.thread);
+		}
+		if (e == events.size() || threads.size() < 2 || writers.empty()) continue;
+
+		uintptr_t first = pos;
+		uintptr_t last  = events[e].pos - 1;
+		std::size_t bytes = 0;
+		for (int i : active) {
+			const access_pattern_t& a = accesses[intervals[i].access];
+			bytes += intervals[i].single ? a.elem_size
+			                             : dense_bytes(a, first * line_size, (last + 1) * line_size);
+		}
+
+		std::vector<int> ids;
+		for (const auto& t : threads) ids.push_back(t.first);
+		int num_writers = static_cast<int>(writers.size());
+
+		shared_lines_t* prev = report.shared.empty() ? nullptr : &report.shared.back();
+		if (prev && prev->first_line + prev->num_lines == first && prev->threads == ids && prev->writers == num_writers) {
+			prev->num_lines       += last - first + 1;
+			prev->bytes_contended += bytes;
+		} else {
+			report.shared.push_back({ first, last - first + 1, ids, num_writers, bytes });
+		}
+		report.total_lines += last - first + 1;
+		report.total_bytes += bytes;
+		report.max_threads  = std::max(report.max_threads, static_cast<int>(ids.size()));
+	}
+	return report;
+}
+
+bool print_false_sharing_report(const false_sharing_report_t& report, std::size_t max_ranges)
+{
+	if (report.shared.empty()) {
+		printf("✅ No false sharing detected - threads access separate cache lines\n");
+		return false;
+	}
+
+	printf("⚠️  False sharing: %zu cache lines in %zu ranges, %zu bytes contended, up to %d threads per line\n",
+	       static_cast<std::size_t>(report.total_lines), report.shared.size(), report.total_bytes, report.max_threads);
+	for (std::size_t r = 0; r < report.shared.size() && r < max_ranges; ++r) {
+		const shared_lines_t& s = report.shared[r];
+		printf("   %#zx", static_cast<std::size_t>(s.first_line * report.line_size));
+		if (s.num_lines > 1) printf(" +%zu lines", static_cast<std::size_t>(s.num_lines));
+		printf(": threads");
+		for (std::size_t t = 0; t < s.threads.size() && t < 8; ++t) printf(" %d", s.threads[t]);
+		if (s.threads.size() > 8) printf(" ... (%zu)", s.threads.size());
+		printf(", %d writing, %zu bytes\n", s.writers, s.bytes_contended);
+	}
+	if (report.shared.size() > max_ranges)
+		printf("   ... %zu more ranges\n", report.shared.size() - max_ranges);
+	return true;
+}
@@ -0,0 +1,64 @@
+#ifndef FALSE_SHARING_H
+#define FALSE_SHARING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "thread_utils.h"
+
+// Elements base[start], base[start + stride], ... below base[end] of one
+// array, each elem_size bytes, accessed by one thread
+struct access_pattern_t
+{
+	int         thread;
+	const void* base;
+	std::size_t elem_size;
+	dim_t       start;
+	dim_t       end;
+	dim_t       stride;   // in elements, 1 = contiguous
+	bool        write;
+};
+
+// Contiguous [start, end) of an array of elem_size-byte elements
+access_pattern_t contiguous_access(int thread, const void* base, std::size_t elem_size,
+                                   dim_t start, dim_t end, bool write);
+
+// Every stride-th element of [start, end), e.g. the cyclic distribution
+// start = thread, stride = n_way
+access_pattern_t strided_access(int thread, const void* base, std::size_t elem_size,
+                                dim_t start, dim_t end, dim_t stride, bool write);
+
+// Consecutive cache lines touched by the same set of threads, at least
+// one of them writing
+struct shared_lines_t
+{
+	uintptr_t        first_line;        // address / line_size
+	uintptr_t        num_lines;
+	std::vector<int> threads;           // ascending
+	int              writers;           // threads that write these lines
+	std::size_t      bytes_contended;   // bytes of these lines the threads touch
+};
+
+struct false_sharing_report_t
+{
+	std::size_t                 line_size;
+	std::vector<shared_lines_t> shared;           // ascending addresses
+	uintptr_t                   total_lines;
+	std::size_t                 total_bytes;
+	int                         max_threads;      // most threads on one line
+};
+
+// Find every cache line that two or more threads touch while at least one
+// writes it. The accesses are turned into line intervals and swept in
+// address order, so the cost is O(P log P) in the number of intervals
+// (one per contiguous or dense strided pattern, one per element for
+// patterns sparser than a line) rather than quadratic in the threads.
+// Bytes that several threads touch are counted once per thread.
+false_sharing_report_t analyze_false_sharing(const std::vector<access_pattern_t>& accesses,
+                                             std::size_t line_size);
+
+// Summary plus the first max_ranges shared ranges; returns true if any
+// line is shared
+bool print_false_sharing_report(const false_sharing_report_t& report, std::size_t max_ranges = 8);
+
+#endif // FALSE_SHARING_H
@@ -0,0 +1,248 @@
+#include "huge_pages.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+#define THP_SIZE (std::size_t(2) << 20)
+
+struct page_mapping_t
+{
+	void*          base;
+	std::size_t    length;   // 0 for posix_memalign
+	page_backend_t backend;
+};
+
+static std::mutex                       mappings_mutex;
+static std::map<void*, page_mapping_t>  mappings;   // user pointer -> mapping
+static page_backend_t                   requested = PAGES_DEFAULT;
+static page_backend_t                   used      = PAGES_DEFAULT;
+static std::string                      fallback_reason;
+
+static std::string read_line(const std::string& path)
+{
+	std::ifstream in(path);
+	std::string line;
+	std::getline(in, line);
+	return line;
+}
+
+static std::size_t round_up(std::size_t bytes, std::size_t align)
+{
+	return (bytes + align - 1) / align * align;
+}
+
+bool parse_page_backend(const char* name, page_backend_t* backend)
+{
+	for (int i = PAGES_DEFAULT; i <= PAGES_HUGETLB_1G; ++i) {
+		if (std::strcmp(name, page_backend_name(static_cast<page_backend_t>(i))) == 0) {
+			*backend = static_cast<page_backend_t>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* page_backend_name(page_backend_t backend)
+{
+	switch (backend) {
+		case PAGES_THP:        return "thp";
+		case PAGES_HUGETLB_2M: return "2m";
+		case PAGES_HUGETLB_1G: return "1g";
+		default:               return "default";
+	}
+}
+
+std::size_t page_backend_size(page_backend_t backend)
+{
+	switch (backend) {
+		case PAGES_THP:
+		case PAGES_HUGETLB_2M: return THP_SIZE;
+		case PAGES_HUGETLB_1G: return std::size_t(1) << 30;
+		default:               return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+	}
+}
+
+void set_page_backend(page_backend_t backend)
+{
+	std::lock_guard<std::mutex> lock(mappings_mutex);
+	requested = backend;
+}
+
+page_backend_t requested_page_backend()
+{
+	std::lock_guard<std::mutex> lock(mappings_mutex);
+	return requested;
+}
+
+page_backend_t used_page_backend()
+{
+	std::lock_guard<std::mutex> lock(mappings_mutex);
+	return used;
+}
+
+const std::string& page_fallback_reason()
+{
+	std::lock_guard<std::mutex> lock(mappings_mutex);
+	return fallback_reason;
+}
+
+static bool map_hugetlb(std::size_t bytes, int shift, page_mapping_t* mapping, std::string* why)
+{
+	std::size_t page = std::size_t(1) << shift;
+	std::size_t length = round_up(bytes ? bytes : 1, page);
+	void* base = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+	                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0);
+	if (base == MAP_FAILED) {
+		// ENOMEM here almost always means the pool is too small
+		std::string dir = "/sys/kernel/mm/hugepages/hugepages-" + std::to_string(page >> 10) + "kB/";
+		std::string free_count = read_line(dir + "free_hugepages");
+		std::ostringstream out;
+		out << "MAP_HUGETLB " << (shift == 30 ? "1 GiB" : "2 MiB") << ": " << std::strerror(errno);
+		if (free_count.empty()) out << " (no " << (page >> 10) << " kB pool in " << dir << ")";
+		else out << " (" << free_count << " free, " << length / page << " needed)";
+		*why = out.str();
+		return false;
+	}
+	mapping->base = base;
+	mapping->length = length;
+	return true;
+}
+
+static bool map_thp(std::size_t bytes, page_mapping_t* mapping, std::string* why)
+{
+	std::string enabled = read_line("/sys/kernel/mm/transparent_hugepage/enabled");
+	if (enabled.empty() || enabled.find("[never]") != std::string::npos) {
+		*why = enabled.empty() ? "THP: not supported by the kernel" : "THP: disabled (" + enabled + ")";
+		return false;
+	}
+
+	// Over-allocate by one huge page and trim, so the buffer starts on a
+	// 2 MiB boundary and every full 2 MiB of it can be a huge page
+	std::size_t length = round_up(bytes ? bytes : 1, THP_SIZE);
+	void* raw = mmap(nullptr, length + THP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED) {
+		*why = std::string("THP: mmap: ") + std::strerror(errno);
+		return false;
+	}
+	uintptr_t start = round_up(reinterpret_cast<uintptr_t>(raw), THP_SIZE);
+	std::size_t head = start - reinterpret_cast<uintptr_t>(raw);
+	if (head) munmap(raw, head);
+	if (THP_SIZE - head) munmap(reinterpret_cast<char*>(start) + length, THP_SIZE - head);
+
+	void* base = reinterpret_cast<void*>(start);
+	if (madvise(base, length, MADV_HUGEPAGE) != 0) {
+		*why = std::string("THP: madvise(MADV_HUGEPAGE): ") + std::strerror(errno);
+		munmap(base, length);
+		return false;
+	}
+	mapping->base = base;
+	mapping->length = length;
+	return true;
+}
+
+void* allocate_pages(std::size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mappings_mutex);
+	std::string reasons;
+
+	page_mapping_t mapping = { nullptr, 0, requested };
+	for (;;) {
+		std::string why;
+		bool ok = false;
+		switch (mapping.backend) {
+			case PAGES_HUGETLB_1G: ok = map_hugetlb(bytes, 30, &mapping, &why); break;
+			case PAGES_HUGETLB_2M: ok = map_hugetlb(bytes, 21, &mapping, &why); break;
+			case PAGES_THP:        ok = map_thp(bytes, &mapping, &why); break;
+			default:
+				if (posix_memalign(&mapping.base, 64, bytes)) {
+					std::cerr << "Failed to allocate aligned memory\n";
+					std::exit(1);
+				}
+				ok = true;
+				break;
+		}
+		if (ok) break;
+		reasons += (reasons.empty() ? "" : "; ") + why;
+		mapping.backend = static_cast<page_backend_t>(mapping.backend - 1);
+	}
+
+	used = mapping.backend;
+	fallback_reason = reasons;
+	mappings[mapping.base] = mapping;
+	return mapping.base;
+}
+
+void free_pages(void* ptr)
+{
+	if (!ptr) return;
+	std::lock_guard<std::mutex> lock(mappings_mutex);
+	auto it = mappings.find(ptr);
+	if (it == mappings.end()) {
+		std::cerr << "free_pages: " << ptr << " was not allocated by allocate_pages\n";
+		std::abort();
+	}
+	if (it->second.length) munmap(it->second.base, it->second.length);
+	else free(it->second.base);
+	mappings.erase(it);
+}
+
+std::size_t huge_page_bytes(const void* ptr, std::size_t bytes)
+{
+	std::ifstream smaps("/proc/self/smaps");
+	if (!smaps.good()) return 0;
+
+	uintptr_t lo = reinterpret_cast<uintptr_t>(ptr), hi = lo + bytes;
+	uintptr_t vma_lo = 0, vma_hi = 0;
+	bool overlaps = false;
+	std::size_t total = 0;
+	std::string line;
+	while (std::getline(smaps, line)) {
+		std::istringstream fields(line);
+		std::string key;
+		fields >> key;
+		if (key.empty()) continue;
+		if (key.back() != ':') {
+			// Header of the next mapping: "start-end perms offset ..."
+			std::size_t dash = key.find('-');
+			if (dash == std::string::npos) continue;
+			vma_lo = std::strtoull(key.c_str(), nullptr, 16);
+			vma_hi = std::strtoull(key.c_str() + dash + 1, nullptr, 16);
+			overlaps = vma_lo < hi && lo < vma_hi;
+			continue;
+		}
+		if (!overlaps) continue;
+
+		std::size_t kb = 0;
+		fields >> kb;
+		std::size_t overlap = std::min(hi, vma_hi) - std::max(lo, vma_lo);
+		if (key == "KernelPageSize:" && kb > 4) total += overlap;                         // hugetlbfs
+		if (key == "AnonHugePages:" && kb) total += std::min(overlap, kb * std::size_t(1024));   // THP
+	}
+	return total;
+}
+
+void print_page_report(const char* label, const void* ptr, std::size_t bytes)
+{
+	page_backend_t req = requested_page_backend(), got = used_page_backend();
+	printf("📄 %s pages: %s", label, page_backend_name(got));
+	if (got != req) printf(" (requested %s)", page_backend_name(req));
+	if (got != PAGES_DEFAULT)
+		printf(", %.1f of %.1f MiB on huge pages", huge_page_bytes(ptr, bytes) / 1048576.0, bytes / 1048576.0);
+	printf("\n");
+	if (got != req) printf("⚠️  Huge pages unavailable: %s\n", page_fallback_reason().c_str());
+}
@@ -0,0 +1,51 @@
+#ifndef HUGE_PAGES_H
+#define HUGE_PAGES_H
+
+#include <cstddef>
+#include <string>
+
+// Where the pages of the benchmark buffers come from
+enum page_backend_t
+{
+	PAGES_DEFAULT = 0,   // posix_memalign, 4 KiB pages (THP only if the system default is "always")
+	PAGES_THP,           // 2 MiB aligned anonymous mmap + madvise(MADV_HUGEPAGE)
+	PAGES_HUGETLB_2M,    // mmap(MAP_HUGETLB | MAP_HUGE_2MB) from the hugetlbfs pool
+	PAGES_HUGETLB_1G     // mmap(MAP_HUGETLB | MAP_HUGE_1GB)
+};
+
+// Parse "default", "thp", "2m" or "1g"; returns false on unknown names
+bool parse_page_backend(const char* name, page_backend_t* backend);
+
+const char* page_backend_name(page_backend_t backend);
+
+// Backend for the buffers allocated from now on (default PAGES_DEFAULT)
+void set_page_backend(page_backend_t backend);
+page_backend_t requested_page_backend();
+
+// Backend the most recent allocation actually got, and why it differs
+// from the requested one (empty if it does not). A failing backend falls
+// back to the next smaller one: 1g -> 2m -> thp -> default.
+page_backend_t used_page_backend();
+const std::string& page_fallback_reason();
+
+// Size of the pages backend maps: the base page size for PAGES_DEFAULT,
+// 2 MiB for PAGES_THP and PAGES_HUGETLB_2M, 1 GiB for PAGES_HUGETLB_1G
+std::size_t page_backend_size(page_backend_t backend);
+
+// bytes starting on a 64-byte line (and on a page for the mmap backends).
+// Exits on failure like the other allocators.
+void* allocate_pages(std::size_t bytes);
+
+// Release a pointer returned by allocate_pages()
+void free_pages(void* ptr);
+
+// Bytes of [ptr, ptr + bytes) backed by huge pages according to
+// /proc/self/smaps (AnonHugePages for THP, the whole mapping for
+// hugetlbfs); 0 if unknown
+std::size_t huge_page_bytes(const void* ptr, std::size_t bytes);
+
+// Print the backend of the most recent allocation, the huge page coverage
+// of [ptr, ptr + bytes) (touch the buffer first) and any fallback reason
+void print_page_report(const char* label, const void* ptr, std::size_t bytes);
+
+#endif // HUGE_PAGES_H
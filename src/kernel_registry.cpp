@@ -0,0 +1,429 @@
+#include "kernel_registry.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <immintrin.h>
+#include "benchmark_common.h"
+#include "write_tracker.h"
+#include "timeline.h"
+
+bool parse_partition(const char* name, partition_t* partition)
+{
+	for (int i = PARTITION_INDEX; i <= PARTITION_LINE; ++i) {
+		if (std::strcmp(name, partition_name(static_cast<partition_t>(i))) == 0) {
+			*partition = static_cast<partition_t>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* partition_name(partition_t partition)
+{
+	switch (partition) {
+		case PARTITION_LINE:   return "line";
+		case PARTITION_CHUNKS: return "chunks";
+		case PARTITION_CYCLIC: return "cyclic";
+		default:               return "index";
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Vector add: C[i] = A[i] + B[i] for every element type
+
+template <typename T>
+static void add_init(const kernel_call_t& call, dim_t start, dim_t end)
+{
+	T* A = static_cast<T*>(const_cast<void*>(call.in0));
+	T* B = static_cast<T*>(const_cast<void*>(call.in1));
+	T* C = static_cast<T*>(call.out);
+	std::fill(A + start, A + end, elem_traits<T>::value(1));
+	std::fill(B + start, B + end, elem_traits<T>::value(2));
+	std::fill(C + start, C + end, elem_traits<T>::value(0));
+}
+
+template <typename T>
+static void add_range(const kernel_call_t& call, dim_t start, dim_t end)
+{
+	const T* A = static_cast<const T*>(call.in0);
+	const T* B = static_cast<const T*>(call.in1);
+	T* C = static_cast<T*>(call.out);
+	for (dim_t i = start; i < end; ++i) {
+		C[i] = A[i] + B[i];
+	}
+	TRACK_WRITES(C + start, end - start, sizeof(T));
+}
+
+// Each thread processes every Nth element (N = number of threads), so
+// adjacent elements are written by different threads and nearly every
+// line of C is shared
+template <typename T>
+static void add_interleaved(const kernel_call_t& call, int work_id, int n_way)
+{
+	const T* A = static_cast<const T*>(call.in0);
+	const T* B = static_cast<const T*>(call.in1);
+	T* C = static_cast<T*>(call.out);
+	for (dim_t i = work_id; i < call.n; i += n_way) {
+		C[i] = A[i] + B[i];
+		TRACK_WRITE(C + i);
+	}
+}
+
+// Streaming add of [start, end) for any element type whose size divides
+// 16 bytes: whole 16-byte blocks of C are computed into a register-sized
+// buffer and written with one non-temporal store. The peel up to the
+// first aligned block and the tail use regular stores.
+template <typename T>
+static void stream_add_range(const T* A, const T* B, T* C, dim_t start, dim_t end, simd_isa_t)
+{
+	static_assert(16 % sizeof(T) == 0, "element size must divide 16 bytes");
+	const dim_t per_block = 16 / sizeof(T);
+	dim_t i = start;
+	for (; i < end && (reinterpret_cast<uintptr_t>(C + i) & 15); ++i) C[i] = A[i] + B[i];
+	for (; i + per_block <= end; i += per_block) {
+		alignas(16) T block[per_block];
+		for (dim_t k = 0; k < per_block; ++k) block[k] = A[i + k] + B[i + k];
+		_mm_stream_si128(reinterpret_cast<__m128i*>(C + i), _mm_load_si128(reinterpret_cast<const __m128i*>(block)));
+	}
+	for (; i < end; ++i) C[i] = A[i] + B[i];
+	_mm_sfence();
+}
+
+// Floats use the _mm_stream_ps/_mm256_stream_ps/_mm512_stream_ps kernels
+static void stream_add_range(const float* A, const float* B, float* C, dim_t start, dim_t end, simd_isa_t isa)
+{
+	select_stream_add_kernel(isa)(A, B, C, start, end);
+}
+
+template <typename T>
+static void add_stream(const kernel_call_t& call, dim_t start, dim_t end)
+{
+	stream_add_range(static_cast<const T*>(call.in0), static_cast<const T*>(call.in1),
+	                 static_cast<T*>(call.out), start, end, call.isa);
+	TRACK_WRITES(static_cast<T*>(call.out) + start, end - start, sizeof(T));
+}
+
+template <typename T>
+static void register_add_kernels()
+{
+	const elem_type_t type = elem_traits<T>::type;
+	// Two loads and one store per element, one add per scalar
+	const double bytes = 3.0 * sizeof(T);
+	const double flops = std::is_same<T, vec4_t>::value ? 4.0 : 1.0;
+	register_kernel({ "add", "C = A + B, blocked", type, sizeof(T), 2, bytes,
+	                  add_init<T>, add_range<T>, nullptr, flops });
+	register_kernel({ "add_interleaved", "C = A + B, element i on thread i % threads", type, sizeof(T), 2, bytes,
+	                  add_init<T>, nullptr, add_interleaved<T>, flops });
+	register_kernel({ "add_stream", "C = A + B, blocked, non-temporal stores to C", type, sizeof(T), 2, bytes,
+	                  add_init<T>, add_stream<T>, nullptr, flops });
+}
+
+// ---------------------------------------------------------------------------
+// Arithmetic: x = sqrt(x) + sin(x) * cos(x) in place, floats only
+
+// Values between 1.0 and 2.0
+static void arith_init(const kernel_call_t& call, dim_t start, dim_t end)
+{
+	float* data = static_cast<float*>(call.out);
+	for (dim_t i = start; i < end; ++i) {
+		data[i] = 1.0f + (i % 100) * 0.01f;
+	}
+}
+
+static void arith_scalar(const kernel_call_t& call, dim_t start, dim_t end)
+{
+	select_arith_kernel(ISA_SCALAR)(static_cast<float*>(call.out), start, end);
+	TRACK_WRITES(static_cast<float*>(call.out) + start, end - start, sizeof(float));
+}
+
+static void arith_simd(const kernel_call_t& call, dim_t start, dim_t end)
+{
+	select_arith_kernel(call.isa)(static_cast<float*>(call.out), start, end);
+	TRACK_WRITES(static_cast<float*>(call.out) + start, end - start, sizeof(float));
+}
+
+// Skewed version of the kernel: the elements of [start, end) get
+// 1 + skew * i / n passes, so the cost per element ramps up linearly and
+// the last thread of a static partition has about 1 + skew passes per
+// element against an average of 1 + skew / 2. Every pass maps x >= 0 to
+// sqrt(x) + sin(2x) / 2 >= 0, so the values stay in the kernel's domain.
+static void skewed_range(arith_kernel_t kernel, const kernel_call_t& call, dim_t start, dim_t end)
+{
+	float* data = static_cast<float*>(call.out);
+	const dim_t step = line_block_factor(sizeof(float), CACHE_LINE_SIZE);
+	for (dim_t i = start; i < end; ) {
+		// Up to the next line of the index space, so every element of a
+		// chunk gets its own pass count whatever the chunk size
+		dim_t stop = std::min(end, (i / step + 1) * step);
+		int passes = 1 + static_cast<int>(call.skew * i / call.n);
+		for (int p = 0; p < passes; ++p) {
+			kernel(data, i, stop);
+			TRACK_WRITES(data + i, stop - i, sizeof(float));
+		}
+		i = stop;
+	}
+}
+
+static void arith_skewed_scalar(const kernel_call_t& call, dim_t start, dim_t end)
+{
+	skewed_range(select_arith_kernel(ISA_SCALAR), call, start, end);
+}
+
+static void arith_skewed_simd(const kernel_call_t& call, dim_t start, dim_t end)
+{
+	skewed_range(select_arith_kernel(call.isa), call, start, end);
+}
+
+static void register_arith_kernels()
+{
+	// Every element is read and written once per pass. One pass is 27
+	// flops in the SIMD kernels: range reduction 7, sin 7, cos 9, sqrt 1,
+	// the final multiply-add 2 (counted the same for libm). The skewed
+	// kernels make a varying number of passes and are left off the roofline.
+	const double bytes = 2.0 * sizeof(float);
+	const double flops = 27.0;
+	register_kernel({ "arith", "sqrt(x) + sin(x) * cos(x) in place, libm", ELEM_FLOAT, sizeof(float), 0, bytes,
+	                  arith_init, arith_scalar, nullptr, flops });
+	register_kernel({ "arith_simd", "sqrt(x) + sin(x) * cos(x) in place, SIMD (--isa)", ELEM_FLOAT, sizeof(float), 0, bytes,
+	                  arith_init, arith_simd, nullptr, flops });
+	register_kernel({ "arith_skewed", "arith with 1 + skew * i / n passes per element, libm", ELEM_FLOAT, sizeof(float), 0, bytes,
+	                  arith_init, arith_skewed_scalar, nullptr, 0.0 });
+	register_kernel({ "arith_skewed_simd", "arith with 1 + skew * i / n passes per element, SIMD", ELEM_FLOAT, sizeof(float), 0, bytes,
+	                  arith_init, arith_skewed_simd, nullptr, 0.0 });
+}
+
+// ---------------------------------------------------------------------------
+// Registry
+
+static std::vector<kernel_desc_t>& registry()
+{
+	static std::vector<kernel_desc_t> kernels;
+	return kernels;
+}
+
+static void register_builtin_kernels()
+{
+	static bool registered = false;
+	if (registered) return;
+	registered = true;
+	register_add_kernels<float>();
+	register_add_kernels<double>();
+	register_add_kernels<int8_t>();
+	register_add_kernels<uint16_t>();
+	register_add_kernels<vec4_t>();
+	register_arith_kernels();
+}
+
+void register_kernel(const kernel_desc_t& kernel)
+{
+	register_builtin_kernels();
+	std::vector<kernel_desc_t>& kernels = registry();
+	for (kernel_desc_t& existing : kernels) {
+		if (std::strcmp(existing.name, kernel.name) == 0 && existing.type == kernel.type) {
+			existing = kernel;
+			return;
+		}
+	}
+	kernels.push_back(kernel);
+}
+
+const std::vector<kernel_desc_t>& kernel_registry()
+{
+	register_builtin_kernels();
+	return registry();
+}
+
+const kernel_desc_t* find_kernel(const std::string& name, elem_type_t type)
+{
+	for (const kernel_desc_t& kernel : kernel_registry())
+		if (name == kernel.name && kernel.type == type) return &kernel;
+	return nullptr;
+}
+
+bool kernel_exists(const std::string& name)
+{
+	for (const kernel_desc_t& kernel : kernel_registry())
+		if (name == kernel.name) return true;
+	return false;
+}
+
+// ---------------------------------------------------------------------------
+// Running a kernel
+
+void kernel_block_range
+     (
+       const kernel_desc_t& kernel,
+       const kernel_call_t& call,
+       partition_t          partition,
+       int                  n_way,
+       int                  work_id,
+       dim_t*               start,
+       dim_t*               end
+     )
+{
+	// Only the output is written, so the line partition aligns the
+	// boundaries to it; the inputs are read-only and cannot false share
+	const dim_t bf = line_block_factor(kernel.elem_size, CACHE_LINE_SIZE);
+	if ( partition == PARTITION_LINE )
+		thread_block_partition_aligned( n_way, call.n, bf, work_id, false, call.out, kernel.elem_size,
+		                                CACHE_LINE_SIZE, start, end );
+	else
+		thread_block_partition( n_way, call.n, bf, work_id, false, start, end );
+}
+
+void init_kernel_buffers
+     (
+       const kernel_desc_t& kernel,
+       const kernel_call_t& call,
+       partition_t          partition,
+       ParallelExecutor&    exec
+     )
+{
+	kernel_range_fn_t init = kernel.init;
+	if (partition != PARTITION_LINE) partition = PARTITION_INDEX;
+	exec.run([&](int work_id, int n_way) {
+		dim_t start, end;
+		kernel_block_range(kernel, call, partition, n_way, work_id, &start, &end);
+		init(call, start, end);
+	});
+}
+
+double run_kernel
+     (
+       const kernel_desc_t&  kernel,
+       const kernel_call_t&  call,
+       const kernel_split_t& split,
+       ParallelExecutor&     exec,
+       ChunkScheduler&       sched
+     )
+{
+	if (kernel.cyclic) {
+		kernel_thread_fn_t cyclic = kernel.cyclic;
+		return exec.run_timed([&](int work_id, int n_way) { cyclic(call, work_id, n_way); });
+	}
+
+	kernel_range_fn_t range = kernel.range;
+	if (split.partition == PARTITION_CHUNKS) {
+		sched.prepare(split.schedule, make_chunk_plan(call.n, call.out, kernel.elem_size, CACHE_LINE_SIZE, split.chunk_lines));
+		return exec.run_timed([&](int work_id, int n_way) {
+			sched.execute(work_id, n_way, [&](dim_t start, dim_t end) { range(call, start, end); });
+		});
+	}
+	return exec.run_timed([&](int work_id, int n_way) {
+		dim_t start, end;
+		kernel_block_range(kernel, call, split.partition, n_way, work_id, &start, &end);
+		uint64_t tick = timeline_chunk_begin();
+		range(call, start, end);
+		timeline_chunk_end(tick, start, end);
+	});
+}
+
+std::vector<access_pattern_t> kernel_accesses
+     (
+       const kernel_desc_t&  kernel,
+       const kernel_call_t&  call,
+       const kernel_split_t& split,
+       int                   n_way
+     )
+{
+	std::vector<access_pattern_t> accesses;
+	chunk_plan_t plan = {};
+	if (split.partition == PARTITION_CHUNKS)
+		plan = make_chunk_plan(call.n, call.out, kernel.elem_size, CACHE_LINE_SIZE, split.chunk_lines);
+
+	for (int t = 0; t < n_way; ++t) {
+		dim_t start = 0, end = 0, stride = 1;
+		if (kernel.cyclic) {
+			start = t;
+			end = call.n;
+			stride = n_way;
+		} else if (split.partition == PARTITION_CHUNKS) {
+			dim_t first, last, unused;
+			thread_block_partition(n_way, plan.num_chunks, 1, t, false, &first, &last);
+			if (first < last) {
+				chunk_range(plan, first, &start, &unused);
+				chunk_range(plan, last - 1, &unused, &end);
+			}
+		} else {
+			kernel_block_range(kernel, call, split.partition, n_way, t, &start, &end);
+		}
+		if (kernel.inputs > 0) {
+			accesses.push_back(strided_access(t, call.in0, kernel.elem_size, start, end, stride, false));
+			accesses.push_back(strided_access(t, call.in1, kernel.elem_size, start, end, stride, false));
+		}
+		accesses.push_back(strided_access(t, call.out, kernel.elem_size, start, end, stride, true));
+	}
+	return accesses;
+}
+
+// ---------------------------------------------------------------------------
+// Pipelines
+
+bool pipeline_valid(const std::vector<const kernel_desc_t*>& stages, std::string* error)
+{
+	if (stages.empty()) {
+		*error = "no stages";
+		return false;
+	}
+	for (std::size_t i = 0; i < stages.size(); ++i) {
+		if (!stages[i]->range) {
+			*error = std::string(stages[i]->name) + " is not a blocked kernel";
+			return false;
+		}
+		if (i > 0 && stages[i]->inputs != 0) {
+			*error = std::string(stages[i]->name) + " reads inputs, only the first stage may";
+			return false;
+		}
+	}
+	return true;
+}
+
+double pipeline_bytes_per_elem(const std::vector<const kernel_desc_t*>& stages, bool fused)
+{
+	if (fused) return stages[0]->bytes_per_elem;
+	double bytes = 0.0;
+	for (const kernel_desc_t* stage : stages) bytes += stage->bytes_per_elem;
+	return bytes;
+}
+
+double run_pipeline_unfused
+     (
+       const std::vector<const kernel_desc_t*>& stages,
+       const kernel_call_t&                     call,
+       const kernel_split_t&                    split,
+       ParallelExecutor&                        exec,
+       ChunkScheduler&                          sched
+     )
+{
+	double time = 0.0;
+	for (const kernel_desc_t* stage : stages) time += run_kernel(*stage, call, split, exec, sched);
+	return time;
+}
+
+double run_pipeline_fused
+     (
+       const std::vector<const kernel_desc_t*>& stages,
+       const kernel_call_t&                     call,
+       partition_t                              partition,
+       dim_t                                    block_elems,
+       ParallelExecutor&                        exec
+     )
+{
+	// Blocks end on the lines of out: at p + j * block_elems, p being the
+	// first aligned element, so a block never splits a line with the next
+	const dim_t p = alignment_prologue( call.out, stages[0]->elem_size, CACHE_LINE_SIZE );
+	return exec.run_timed([&](int work_id, int n_way) {
+		dim_t start, end;
+		kernel_block_range(*stages[0], call, partition, n_way, work_id, &start, &end);
+		for (dim_t b = start; b < end; ) {
+			dim_t next = b < p ? p : p + ((b - p) / block_elems + 1) * block_elems;
+			dim_t stop = std::min(end, next);
+			uint64_t tick = timeline_chunk_begin();
+			for (const kernel_desc_t* stage : stages) stage->range(call, b, stop);
+			timeline_chunk_end(tick, b, stop);
+			b = stop;
+		}
+	});
+}
@@ -0,0 +1,170 @@
+#ifndef KERNEL_REGISTRY_H
+#define KERNEL_REGISTRY_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "thread_utils.h"
+#include "thread_pool.h"
+#include "element_types.h"
+#include "simd_kernels.h"
+#include "false_sharing.h"
+#include "work_scheduler.h"
+
+// How the threads share [0, n) of a blocked kernel
+enum partition_t
+{
+	PARTITION_INDEX = 0,   // thread_block_partition(): whole lines counted from index 0
+	PARTITION_LINE,        // thread_block_partition_aligned(): boundaries on the lines of the output
+	PARTITION_CHUNKS,      // line-aligned chunks handed out by a ChunkScheduler
+	PARTITION_CYCLIC       // thread t takes t, t + n_way, ... (cyclic kernels only)
+};
+
+// Parse "index" or "line"; the other two follow from the schedule and the kernel
+bool parse_partition(const char* name, partition_t* partition);
+
+const char* partition_name(partition_t partition);
+
+// Buffers and parameters of one kernel call. The inputs are line aligned;
+// out is offset bytes past a line for the misaligned runs.
+struct kernel_call_t
+{
+	const void* in0;
+	const void* in1;
+	void*       out;
+	dim_t       n;        // elements
+	simd_isa_t  isa;      // instruction set of the SIMD kernels
+	double      skew;     // the skewed kernels give element i 1 + skew * i / n passes
+};
+
+// Fill the buffers of [start, end) / compute [start, end) of the output
+typedef void (*kernel_range_fn_t)(const kernel_call_t& call, dim_t start, dim_t end);
+
+// Whole share of work_id for kernels that are not split in ranges
+typedef void (*kernel_thread_fn_t)(const kernel_call_t& call, int work_id, int n_way);
+
+// One benchmarkable kernel, instantiated for one element type. Blocked
+// kernels provide range and are split by the driver with any partition or
+// schedule; cyclic kernels provide cyclic and split the index space
+// themselves.
+struct kernel_desc_t
+{
+	const char*        name;
+	const char*        description;
+	elem_type_t        type;
+	std::size_t        elem_size;
+	int                inputs;           // 2: out = f(in0, in1); 0: in place on out
+	double             bytes_per_elem;   // loads + stores per element and call, for GB/s
+	kernel_range_fn_t  init;             // fill in0, in1 and out; idempotent
+	kernel_range_fn_t  range;            // blocked kernels, else nullptr
+	kernel_thread_fn_t cyclic;           // cyclic kernels, else nullptr
+	double             flops_per_elem;   // arithmetic per element and call, for the roofline; 0 if unknown
+};
+
+// Add a kernel to the registry; later kernels with the same name and
+// type replace earlier ones
+void register_kernel(const kernel_desc_t& kernel);
+
+// Every registered kernel (the built-in ones first), in registration order
+const std::vector<kernel_desc_t>& kernel_registry();
+
+// Kernel by name and element type; nullptr if there is none
+const kernel_desc_t* find_kernel(const std::string& name, elem_type_t type);
+
+// True if some element type has a kernel of this name
+bool kernel_exists(const std::string& name);
+
+// How one cell of the benchmark matrix splits the work. schedule and
+// chunk_lines are only used with PARTITION_CHUNKS.
+struct kernel_split_t
+{
+	partition_t partition;
+	schedule_t  schedule;
+	dim_t       chunk_lines;
+};
+
+// Range of work_id under PARTITION_INDEX or PARTITION_LINE, in whole cache
+// lines of the kernel's elements
+void kernel_block_range
+     (
+       const kernel_desc_t& kernel,
+       const kernel_call_t& call,
+       partition_t          partition,
+       int                  n_way,
+       int                  work_id,
+       dim_t*               start,
+       dim_t*               end
+     );
+
+// Fill the buffers in parallel, every thread the range partition gives
+// it, so a first touch places the pages where that partition runs. The
+// chunk and cyclic partitions have no fixed owner and fill by
+// PARTITION_INDEX.
+void init_kernel_buffers
+     (
+       const kernel_desc_t& kernel,
+       const kernel_call_t& call,
+       partition_t          partition,
+       ParallelExecutor&    exec
+     );
+
+// One parallel call of the kernel; returns the longest time any thread
+// spent inside it. sched is only used with PARTITION_CHUNKS.
+double run_kernel
+     (
+       const kernel_desc_t&  kernel,
+       const kernel_call_t&  call,
+       const kernel_split_t& split,
+       ParallelExecutor&     exec,
+       ChunkScheduler&       sched
+     );
+
+// What each thread reads and writes in one call, for
+// analyze_false_sharing(). Chunked splits are described by the chunks
+// SCHED_STATIC would give each thread; every chunk boundary is a line
+// boundary, so the other schedules share no more lines.
+std::vector<access_pattern_t> kernel_accesses
+     (
+       const kernel_desc_t&  kernel,
+       const kernel_call_t&  call,
+       const kernel_split_t& split,
+       int                   n_way
+     );
+
+// Element-wise kernels chained over the same call: the first stage may
+// read in0 and in1, every later one works in place on out. Returns false
+// and says why if a stage cannot be chained (cyclic, or with inputs after
+// the first stage).
+bool pipeline_valid(const std::vector<const kernel_desc_t*>& stages, std::string* error);
+
+// Bytes one pipeline call moves to and from memory per element: every
+// stage's own traffic when the stages run one after another, only the
+// first stage's (its inputs and out, once) when they are fused and the
+// intermediates stay in cache
+double pipeline_bytes_per_elem(const std::vector<const kernel_desc_t*>& stages, bool fused);
+
+// Every stage over the whole vector, one parallel call per stage; returns
+// the summed in-kernel time of the slowest thread of each call
+double run_pipeline_unfused
+     (
+       const std::vector<const kernel_desc_t*>& stages,
+       const kernel_call_t&                     call,
+       const kernel_split_t&                    split,
+       ParallelExecutor&                        exec,
+       ChunkScheduler&                          sched
+     );
+
+// One parallel call: every thread walks its PARTITION_INDEX or
+// PARTITION_LINE range in blocks of block_elems (whole lines of out) and
+// runs all stages on a block before moving to the next one. Returns the
+// longest time any thread spent inside.
+double run_pipeline_fused
+     (
+       const std::vector<const kernel_desc_t*>& stages,
+       const kernel_call_t&                     call,
+       partition_t                              partition,
+       dim_t                                    block_elems,
+       ParallelExecutor&                        exec
+     );
+
+#endif // KERNEL_REGISTRY_H
@@ -0,0 +1,426 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include "benchmark_common.h"
+#include "struct_layouts.h"
+#include "thread_utils.h"
+#include "thread_pool.h"
+#include "numa_placement.h"
+#include "measurement.h"
+#include "result_store.h"
+#include "false_sharing.h"
+#include "element_types.h"
+
+#define DEFAULT_ELEMENTS (1 << 20)
+#define DEFAULT_BUDGET 0.5       // Seconds per cell; --budget= overrides
+#define RESULTS_PATH "../data/layout_results.csv"
+
+#define DT     0.001f            // Time step of the move kernel
+#define DAMP   0.999f            // Velocity factor of the damp kernel
+#define GROWTH 1.001f            // Mass factor of the mass kernel
+
+// Fields of one particle, 28 bytes: two structs and a bit per line
+enum particle_field_t {
+    FIELD_X, FIELD_Y, FIELD_Z,
+    FIELD_VX, FIELD_VY, FIELD_VZ,
+    FIELD_MASS,
+    NUM_FIELDS
+};
+
+// Updates that touch a subset of the fields
+enum update_kernel_t {
+    KERNEL_MOVE,   // x += dt * vx for x, y, z: 6 fields read, 3 written
+    KERNEL_DAMP,   // vx *= damp for vx, vy, vz: 3 fields read and written
+    KERNEL_MASS    // mass *= growth: 1 of 7 fields read and written
+};
+
+const char* update_kernel_name(update_kernel_t kernel) {
+    switch (kernel) {
+        case KERNEL_DAMP: return "damp";
+        case KERNEL_MASS: return "mass";
+        default:          return "move";
+    }
+}
+
+// Bit f set if the kernel loads / stores field f
+unsigned kernel_reads(update_kernel_t kernel) {
+    switch (kernel) {
+        case KERNEL_DAMP: return 1u << FIELD_VX | 1u << FIELD_VY | 1u << FIELD_VZ;
+        case KERNEL_MASS: return 1u << FIELD_MASS;
+        default:          return 0x3fu;
+    }
+}
+
+unsigned kernel_writes(update_kernel_t kernel) {
+    switch (kernel) {
+        case KERNEL_DAMP: return 1u << FIELD_VX | 1u << FIELD_VY | 1u << FIELD_VZ;
+        case KERNEL_MASS: return 1u << FIELD_MASS;
+        default:          return 1u << FIELD_X | 1u << FIELD_Y | 1u << FIELD_Z;
+    }
+}
+
+enum layout_kind_t {
+    LAYOUT_AOS,
+    LAYOUT_SOA,
+    LAYOUT_AOSOA8,    // tiles of one AVX2 vector
+    LAYOUT_AOSOA16    // tiles of one AVX-512 vector, one line per tile field
+};
+
+const char* layout_kind_name(layout_kind_t layout) {
+    switch (layout) {
+        case LAYOUT_SOA:     return "soa";
+        case LAYOUT_AOSOA8:  return "aosoa8";
+        case LAYOUT_AOSOA16: return "aosoa16";
+        default:             return "aos";
+    }
+}
+
+typedef AosLayout<NUM_FIELDS>       aos_t;
+typedef SoaLayout<NUM_FIELDS>       soa_t;
+typedef AosoaLayout<NUM_FIELDS, 8>  aosoa8_t;
+typedef AosoaLayout<NUM_FIELDS, 16> aosoa16_t;
+
+// Field f of element i before any update
+inline float initial_value(dim_t i, int f) {
+    return 1.0f + f + (i % 97) * 0.01f;
+}
+
+// op(i, count) for every run of the layout in [start, end); within a run
+// field f of element i + k is at layout.field(i, f)[k * Layout::stride]
+template <typename Layout, typename Op>
+inline void for_each_run(const Layout& layout, dim_t start, dim_t end, Op op) {
+    for (dim_t i = start; i < end; ) {
+        const dim_t count = std::min(end - i, layout.run(i));
+        op(i, count);
+        i += count;
+    }
+}
+
+template <typename Layout>
+void update_range(update_kernel_t kernel, const Layout& layout, dim_t start, dim_t end) {
+    constexpr dim_t s = Layout::stride;
+    switch (kernel) {
+        case KERNEL_MOVE:
+            for_each_run(layout, start, end, [&](dim_t i, dim_t count) {
+                float* x = layout.field(i, FIELD_X);
+                float* y = layout.field(i, FIELD_Y);
+                float* z = layout.field(i, FIELD_Z);
+                const float* vx = layout.field(i, FIELD_VX);
+                const float* vy = layout.field(i, FIELD_VY);
+                const float* vz = layout.field(i, FIELD_VZ);
+                for (dim_t k = 0; k < count; ++k) {
+                    x[k * s] += DT * vx[k * s];
+                    y[k * s] += DT * vy[k * s];
+                    z[k * s] += DT * vz[k * s];
+                }
+            });
+            break;
+        case KERNEL_DAMP:
+            for_each_run(layout, start, end, [&](dim_t i, dim_t count) {
+                float* vx = layout.field(i, FIELD_VX);
+                float* vy = layout.field(i, FIELD_VY);
+                float* vz = layout.field(i, FIELD_VZ);
+                for (dim_t k = 0; k < count; ++k) {
+                    vx[k * s] *= DAMP;
+                    vy[k * s] *= DAMP;
+                    vz[k * s] *= DAMP;
+                }
+            });
+            break;
+        case KERNEL_MASS:
+            for_each_run(layout, start, end, [&](dim_t i, dim_t count) {
+                float* mass = layout.field(i, FIELD_MASS);
+                for (dim_t k = 0; k < count; ++k) mass[k * s] *= GROWTH;
+            });
+            break;
+    }
+}
+
+// One parallel call, split with thread_block_partition() in blocks of the layout
+template <typename Layout>
+void update(update_kernel_t kernel, const Layout& layout, dim_t n, ParallelExecutor& exec) {
+    exec.run([&](int work_id, int n_way) {
+        dim_t start, end;
+        thread_block_partition(n_way, n, Layout::block, work_id, false, &start, &end);
+        update_range(kernel, layout, start, end);
+    });
+}
+
+template <typename Layout>
+void initialize(const Layout& layout, dim_t n) {
+    for (dim_t i = 0; i < n; ++i)
+        for (int f = 0; f < NUM_FIELDS; ++f) *layout.field(i, f) = initial_value(i, f);
+}
+
+// Every field after one update of freshly initialized data
+template <typename Layout>
+bool check_update(update_kernel_t kernel, const Layout& layout, dim_t n) {
+    const unsigned writes = kernel_writes(kernel);
+    for (dim_t i = 0; i < n; ++i) {
+        for (int f = 0; f < NUM_FIELDS; ++f) {
+            float expected = initial_value(i, f);
+            if (writes & (1u << f)) {
+                switch (kernel) {
+                    case KERNEL_MOVE: expected += DT * initial_value(i, f + FIELD_VX); break;
+                    case KERNEL_DAMP: expected *= DAMP; break;
+                    case KERNEL_MASS: expected *= GROWTH; break;
+                }
+            }
+            const float got = *layout.field(i, f);
+            if (std::fabs(got - expected) > 1e-6f * std::fabs(expected)) {
+                std::cerr << "❌ " << update_kernel_name(kernel) << ": element " << i << " field " << f << " is "
+                          << got << ", expected " << expected << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Lines the kernel touches and writes over the whole array: each touched
+// line is read once (stores allocate too) and each written line written back
+template <typename Layout>
+void count_bytes(update_kernel_t kernel, const Layout& layout, dim_t n, const float* buffer, std::size_t buffer_floats,
+                 double* bytes_moved, double* useful_bytes) {
+    const unsigned reads = kernel_reads(kernel), writes = kernel_writes(kernel);
+    const std::size_t lines = buffer_floats * sizeof(float) / CACHE_LINE_SIZE + 2;
+    std::vector<char> touched(lines, 0), written(lines, 0);
+    const uintptr_t first = reinterpret_cast<uintptr_t>(buffer) / CACHE_LINE_SIZE;
+    for (int f = 0; f < NUM_FIELDS; ++f) {
+        if (!((reads | writes) & (1u << f))) continue;
+        for (dim_t i = 0; i < n; ++i) {
+            const std::size_t line = reinterpret_cast<uintptr_t>(layout.field(i, f)) / CACHE_LINE_SIZE - first;
+            touched[line] = 1;
+            if (writes & (1u << f)) written[line] = 1;
+        }
+    }
+    const double lines_moved = std::count(touched.begin(), touched.end(), 1) + std::count(written.begin(), written.end(), 1);
+    *bytes_moved = lines_moved * CACHE_LINE_SIZE;
+    *useful_bytes = static_cast<double>(n) * sizeof(float) * (__builtin_popcount(reads | writes) + __builtin_popcount(writes));
+}
+
+// Lines two threads touch with at least one writing, field by field
+template <typename Layout>
+false_sharing_report_t find_false_sharing(update_kernel_t kernel, const Layout& layout, dim_t n, int num_threads) {
+    const unsigned reads = kernel_reads(kernel), writes = kernel_writes(kernel);
+    std::vector<access_pattern_t> accesses;
+    for (int t = 0; t < num_threads; ++t) {
+        dim_t start, end;
+        thread_block_partition(num_threads, n, Layout::block, t, false, &start, &end);
+        if (start >= end) continue;
+        for (int f = 0; f < NUM_FIELDS; ++f)
+            if ((reads | writes) & (1u << f)) accesses.push_back(layout.access(t, f, start, end, (writes & (1u << f)) != 0));
+    }
+    return analyze_false_sharing(accesses, CACHE_LINE_SIZE);
+}
+
+struct layout_cell_t {
+    measure_stats_t time;
+    double bytes_moved;
+    double useful_bytes;
+    false_sharing_report_t sharing;
+};
+
+template <typename Layout>
+bool run_cell(update_kernel_t kernel, float* data, dim_t n, const float* buffer, std::size_t buffer_floats,
+              ParallelExecutor& exec, const measure_config_t& config, layout_cell_t* cell) {
+    Layout layout(data, n);
+    initialize(layout, n);
+    update(kernel, layout, n, exec);
+    if (!check_update(kernel, layout, n)) return false;
+
+    initialize(layout, n);
+    cell->time = measure(config, [&](int) {
+        auto start = std::chrono::steady_clock::now();
+        update(kernel, layout, n, exec);
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    });
+    count_bytes(kernel, layout, n, buffer, buffer_floats, &cell->bytes_moved, &cell->useful_bytes);
+    cell->sharing = find_false_sharing(kernel, layout, n, exec.num_threads());
+    return true;
+}
+
+bool run_layout(layout_kind_t kind, update_kernel_t kernel, float* data, dim_t n, const float* buffer,
+                std::size_t buffer_floats, ParallelExecutor& exec, const measure_config_t& config, layout_cell_t* cell) {
+    switch (kind) {
+        case LAYOUT_SOA:     return run_cell<soa_t>(kernel, data, n, buffer, buffer_floats, exec, config, cell);
+        case LAYOUT_AOSOA8:  return run_cell<aosoa8_t>(kernel, data, n, buffer, buffer_floats, exec, config, cell);
+        case LAYOUT_AOSOA16: return run_cell<aosoa16_t>(kernel, data, n, buffer, buffer_floats, exec, config, cell);
+        default:             return run_cell<aos_t>(kernel, data, n, buffer, buffer_floats, exec, config, cell);
+    }
+}
+
+int main(int argc, char** argv) {
+    begin_run(argc, argv);
+    std::vector<update_kernel_t> kernels = { KERNEL_MOVE, KERNEL_DAMP, KERNEL_MASS };
+    std::vector<layout_kind_t> layouts = { LAYOUT_AOS, LAYOUT_SOA, LAYOUT_AOSOA8, LAYOUT_AOSOA16 };
+    std::vector<std::string> thread_list;
+    std::vector<std::string> offset_list = split_list("0,4");
+    std::size_t elements = DEFAULT_ELEMENTS;
+    exec_backend_t backend = BACKEND_OMP;
+    pin_policy_t pin = PIN_NONE;
+    measure_config_t config = default_measure_config();
+    config.time_budget = DEFAULT_BUDGET;
+    for (int i = 1; i < argc; ++i) {
+        if (parse_measure_option(argv[i], &config)) continue;
+        if (std::strncmp(argv[i], "--threads=", 10) == 0) { thread_list = split_list(argv[i] + 10); continue; }
+        if (std::strncmp(argv[i], "--offsets=", 10) == 0) { offset_list = split_list(argv[i] + 10); continue; }
+        if (std::strncmp(argv[i], "--elements=", 11) == 0) {
+            if (!parse_count(argv[i] + 11, &elements)) {
+                std::cerr << "Invalid element count '" << (argv[i] + 11) << "'\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--kernels=", 10) == 0) {
+            kernels.clear();
+            for (const std::string& name : split_list(argv[i] + 10)) {
+                if (name != "move" && name != "damp" && name != "mass") {
+                    std::cerr << "Unknown layout kernel '" << name << "' (use move, damp or mass)\n";
+                    return 1;
+                }
+                kernels.push_back(name == "move" ? KERNEL_MOVE : name == "damp" ? KERNEL_DAMP : KERNEL_MASS);
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--layouts=", 10) == 0) {
+            layouts.clear();
+            for (const std::string& name : split_list(argv[i] + 10)) {
+                int kind = LAYOUT_AOS;
+                while (kind <= LAYOUT_AOSOA16 && name != layout_kind_name(static_cast<layout_kind_t>(kind))) ++kind;
+                if (kind > LAYOUT_AOSOA16) {
+                    std::cerr << "Unknown layout '" << name << "' (use aos, soa, aosoa8 or aosoa16)\n";
+                    return 1;
+                }
+                layouts.push_back(static_cast<layout_kind_t>(kind));
+            }
+            // AoS first: the other layouts are compared with it
+            std::sort(layouts.begin(), layouts.end());
+            continue;
+        }
+        if (std::strncmp(argv[i], "--backend=", 10) == 0) {
+            if (!parse_exec_backend(argv[i] + 10, &backend)) {
+                std::cerr << "Unknown backend '" << (argv[i] + 10) << "' (use omp or pool)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--pin=", 6) == 0) {
+            if (!parse_pin_policy(argv[i] + 6, &pin)) {
+                std::cerr << "Unknown pin policy '" << (argv[i] + 6) << "' (use none, compact, scatter or smt)\n";
+                return 1;
+            }
+            continue;
+        }
+        std::cerr << "Unknown option '" << argv[i] << "'\n";
+        return 1;
+    }
+
+    std::vector<int> thread_counts;
+    if (thread_list.empty()) thread_list.push_back(std::to_string(get_num_threads()));
+    for (const std::string& text : thread_list) {
+        int threads = std::atoi(text.c_str());
+        if (threads < 1) {
+            std::cerr << "Invalid thread count '" << text << "'\n";
+            return 1;
+        }
+        thread_counts.push_back(threads);
+    }
+    std::vector<std::size_t> offsets;
+    for (const std::string& text : offset_list) {
+        char* end = nullptr;
+        long offset = std::strtol(text.c_str(), &end, 10);
+        if (*end != '\0' || offset < 0 || offset >= CACHE_LINE_SIZE || offset % sizeof(float) != 0) {
+            std::cerr << "Invalid offset '" << text << "' (bytes, a multiple of 4 below " << CACHE_LINE_SIZE << ")\n";
+            return 1;
+        }
+        offsets.push_back(static_cast<std::size_t>(offset));
+    }
+
+    // Whole tiles of the widest AoSoA, so every layout holds the same elements
+    const dim_t n = (elements + 15) / 16 * 16;
+    const std::size_t max_floats = std::max({ aos_t::floats(n), soa_t::floats(n), aosoa8_t::floats(n), aosoa16_t::floats(n) });
+    const std::size_t buffer_floats = max_floats + CACHE_LINE_SIZE / sizeof(float);
+    float* buffer = allocate_aligned_buffer<float>(buffer_floats);
+
+    std::ofstream csv;
+    if (!open_csv(csv, RESULTS_PATH,
+                  "kernel,layout,elements,threads,offset,time,min,p90,cv,runs,gbps,bytes_moved,useful_bytes,vs_aos,"
+                  "vs_aos_significant,shared_lines,contended_bytes,backend,pin")) {
+        std::cerr << "Cannot write results '" << RESULTS_PATH << "'\n";
+        return 1;
+    }
+
+    std::cout << "🧮 Struct Layout Benchmark\n";
+    std::cout << "🧱 " << n << " particles of " << NUM_FIELDS * sizeof(float) << " bytes, backend "
+              << exec_backend_name(backend) << ", pinning " << pin_policy_name(pin) << "\n";
+
+    for (int num_threads : thread_counts) {
+        ParallelExecutor exec(backend, num_threads, pin_policy_cpus(pin, num_threads));
+        for (std::size_t offset : offsets) {
+            float* data = buffer + offset / sizeof(float);
+            std::cout << "\n🧵 " << num_threads << " threads, offset " << offset << " bytes\n";
+            for (update_kernel_t kernel : kernels) {
+                measure_stats_t aos = {};
+                for (layout_kind_t kind : layouts) {
+                    layout_cell_t cell;
+                    if (!run_layout(kind, kernel, data, n, buffer, buffer_floats, exec, config, &cell)) {
+                        free_aligned_buffer(buffer);
+                        return 1;
+                    }
+                    const measure_stats_t& time = cell.time;
+                    if (kind == LAYOUT_AOS) aos = time;
+                    const bool have_aos = aos.runs > 0;
+                    const bool significant = have_aos && stats_differ(aos, time);
+                    const double gbps = cell.bytes_moved / time.median / 1e9;
+
+                    std::cout << (cell.sharing.shared.empty() ? "✅ " : "⚠️  ") << update_kernel_name(kernel) << " "
+                              << layout_kind_name(kind) << ": " << time.median << " sec, " << gbps << " GB/s, "
+                              << cell.bytes_moved / n << " B moved per particle ("
+                              << cell.useful_bytes / cell.bytes_moved * 100.0 << "% used)";
+                    if (kind != LAYOUT_AOS && have_aos)
+                        std::cout << ", " << aos.median / time.median << "x vs aos" << (significant ? "" : " (within noise)");
+                    std::cout << ", " << cell.sharing.total_lines << " shared lines (CV " << time.cv * 100.0 << "%, "
+                              << time.runs << " runs)\n";
+
+                    csv << update_kernel_name(kernel) << "," << layout_kind_name(kind) << "," << n << "," << num_threads
+                        << "," << offset << "," << time.median << "," << time.min << "," << time.p90 << "," << time.cv
+                        << "," << time.runs << "," << gbps << "," << cell.bytes_moved << "," << cell.useful_bytes << ",";
+                    if (have_aos) csv << aos.median / time.median << "," << significant;
+                    else csv << ",";
+                    csv << "," << cell.sharing.total_lines << "," << cell.sharing.total_bytes << ","
+                        << exec_backend_name(backend) << "," << pin_policy_name(pin) << "\n";
+
+                    JsonRecord record;
+                    record.add("benchmark", "layout")
+                          .add("kernel", update_kernel_name(kernel))
+                          .add("layout", layout_kind_name(kind))
+                          .add("elements", static_cast<long long>(n))
+                          .add("threads", num_threads)
+                          .add("offset", offset)
+                          .add("backend", exec_backend_name(backend))
+                          .add("pin", pin_policy_name(pin));
+
+                    JsonRecord result;
+                    result.add("time", time)
+                          .add("gbps", gbps)
+                          .add("bytes_moved", cell.bytes_moved)
+                          .add("useful_bytes", cell.useful_bytes)
+                          .add("shared_lines", static_cast<long long>(cell.sharing.total_lines));
+                    store_result(MEASUREMENTS_PATH, record, result);
+                }
+            }
+        }
+    }
+    free_aligned_buffer(buffer);
+    return 0;
+}
+// g++ -fopenmp -O3 -march=native -std=c++17 -o layout_benchmark layout_benchmark.cpp benchmark_common.cpp thread_utils.cpp thread_pool.cpp numa_placement.cpp perf_counters.cpp write_tracker.cpp timeline.cpp measurement.cpp result_store.cpp cache_info.cpp false_sharing.cpp huge_pages.cpp
+// ./layout_benchmark [--elements=1M] [--threads=2,4,8] [--offsets=0,4] [--kernels=move,damp,mass] [--layouts=aos,soa,aosoa8,aosoa16] [--backend=pool] [--pin=compact]
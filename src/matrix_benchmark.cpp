@@ -0,0 +1,325 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include "benchmark_common.h"
+#include "thread_utils.h"
+#include "thread_pool.h"
+#include "numa_placement.h"
+#include "measurement.h"
+#include "result_store.h"
+#include "false_sharing.h"
+#include "element_types.h"
+#include "huge_pages.h"
+
+#define DEFAULT_SHAPES "1000x1000,100x10000,10000x100"
+#define RESULTS_PATH "../data/matrix_results.csv"
+
+// Row-major matrix updates
+enum matrix_kernel_t {
+    MATRIX_ADD,     // C = A + B
+    MATRIX_RANK1    // C += x * y^T
+};
+
+const char* matrix_kernel_name(matrix_kernel_t kernel) {
+    return kernel == MATRIX_RANK1 ? "rank1" : "add";
+}
+
+// How the threads split the matrix
+enum split_t {
+    SPLIT_ROWS,        // row panels: m_way = threads
+    SPLIT_COLS,        // column panels, columns split evenly element by element
+    SPLIT_COLS_LINE,   // column panels in whole lines of the first row
+    SPLIT_TILES        // m_way x n_way grid, columns in whole lines
+};
+
+const char* split_name(split_t split) {
+    switch (split) {
+        case SPLIT_COLS:      return "cols";
+        case SPLIT_COLS_LINE: return "cols_line";
+        case SPLIT_TILES:     return "tiles";
+        default:              return "rows";
+    }
+}
+
+// One cell of the comparison: a split strategy on a thread grid
+struct strategy_t {
+    split_t split;
+    dim_t m_way;
+    dim_t n_way;
+    bool is_auto;   // the grid thread_grid_factor() picks
+};
+
+// Matrices of one shape and leading dimension, plus the rank-1 vectors
+struct matrices_t {
+    dim_t m, n, ld;
+    float* A;
+    float* B;
+    float* C;
+    std::vector<float> x, y;
+};
+
+// Tile of work_id under a strategy
+void strategy_tile(const strategy_t& s, const matrices_t& mat, int work_id,
+                   dim_t* row_start, dim_t* row_end, dim_t* col_start, dim_t* col_end) {
+    thread_tile_partition(s.m_way, s.n_way, mat.m, mat.n, work_id, s.split != SPLIT_COLS,
+                          mat.C, sizeof(float), CACHE_LINE_SIZE, row_start, row_end, col_start, col_end);
+}
+
+// Every thread updates its tile of C; returns the time the slowest
+// thread spent in the kernel
+double matrix_update(matrix_kernel_t kernel, const strategy_t& s, const matrices_t& mat, ParallelExecutor& exec) {
+    return exec.run_timed([&](int work_id, int) {
+        dim_t r0, r1, c0, c1;
+        strategy_tile(s, mat, work_id, &r0, &r1, &c0, &c1);
+        const dim_t ld = mat.ld;
+        if (kernel == MATRIX_RANK1) {
+            const float* x = mat.x.data();
+            const float* y = mat.y.data();
+            for (dim_t r = r0; r < r1; ++r) {
+                float* C = mat.C + r * ld;
+                const float xr = x[r];
+                for (dim_t c = c0; c < c1; ++c) C[c] += xr * y[c];
+            }
+            return;
+        }
+        for (dim_t r = r0; r < r1; ++r) {
+            const float* A = mat.A + r * ld;
+            const float* B = mat.B + r * ld;
+            float* C = mat.C + r * ld;
+            for (dim_t c = c0; c < c1; ++c) C[c] = A[c] + B[c];
+        }
+    });
+}
+
+// Lines of C the tiles share between threads; A, B, x and y are only read
+false_sharing_report_t find_false_sharing(const strategy_t& s, const matrices_t& mat, int num_threads) {
+    std::vector<access_pattern_t> accesses;
+    for (int t = 0; t < num_threads; ++t) {
+        dim_t r0, r1, c0, c1;
+        strategy_tile(s, mat, t, &r0, &r1, &c0, &c1);
+        for (dim_t r = r0; r < r1 && c0 < c1; ++r)
+            accesses.push_back(contiguous_access(t, mat.C + r * mat.ld, sizeof(float), c0, c1, true));
+    }
+    return analyze_false_sharing(accesses, CACHE_LINE_SIZE);
+}
+
+// Every element of C must have been updated exactly once per call:
+// C = 3 for add, and the same count for every element of the rank-1 update
+bool check_result(matrix_kernel_t kernel, const matrices_t& mat) {
+    const float expected = kernel == MATRIX_ADD ? 3.0f : mat.C[0];
+    for (dim_t r = 0; r < mat.m; ++r)
+        for (dim_t c = 0; c < mat.n; ++c)
+            if (mat.C[r * mat.ld + c] != expected) {
+                std::cerr << "❌ " << matrix_kernel_name(kernel) << ": C(" << r << "," << c << ") = "
+                          << mat.C[r * mat.ld + c] << ", expected " << expected << "\n";
+                return false;
+            }
+    return true;
+}
+
+// Split strategies for one thread count: rows first (the baseline), then
+// both column panels and every grid with more than one row and column panel
+std::vector<strategy_t> strategies(dim_t nt, dim_t m, dim_t n) {
+    dim_t auto_m, auto_n;
+    thread_grid_factor(nt, m, n, &auto_m, &auto_n);
+
+    std::vector<strategy_t> list;
+    list.push_back({ SPLIT_ROWS, nt, 1, auto_n == 1 });
+    if (nt == 1) return list;
+    list.push_back({ SPLIT_COLS, 1, nt, false });
+    list.push_back({ SPLIT_COLS_LINE, 1, nt, auto_m == 1 });
+    for (dim_t ir = 2; ir < nt; ++ir)
+        if (nt % ir == 0) list.push_back({ SPLIT_TILES, ir, nt / ir, ir == auto_m });
+    return list;
+}
+
+int main(int argc, char** argv) {
+    begin_run(argc, argv);
+    std::vector<std::string> shape_list = split_list(DEFAULT_SHAPES);
+    std::vector<std::string> thread_list;
+    std::vector<matrix_kernel_t> kernels = { MATRIX_ADD, MATRIX_RANK1 };
+    std::vector<bool> padded_lds = { false, true };
+    exec_backend_t backend = BACKEND_OMP;
+    pin_policy_t pin = PIN_NONE;
+    measure_config_t config = default_measure_config();
+    for (int i = 1; i < argc; ++i) {
+        if (parse_measure_option(argv[i], &config)) continue;
+        if (std::strncmp(argv[i], "--shapes=", 9) == 0) { shape_list = split_list(argv[i] + 9); continue; }
+        if (std::strncmp(argv[i], "--threads=", 10) == 0) { thread_list = split_list(argv[i] + 10); continue; }
+        if (std::strncmp(argv[i], "--kernels=", 10) == 0) {
+            kernels.clear();
+            for (const std::string& name : split_list(argv[i] + 10)) {
+                if (name != "add" && name != "rank1") {
+                    std::cerr << "Unknown matrix kernel '" << name << "' (use add or rank1)\n";
+                    return 1;
+                }
+                kernels.push_back(name == "add" ? MATRIX_ADD : MATRIX_RANK1);
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--ld=", 5) == 0) {
+            padded_lds.clear();
+            for (const std::string& name : split_list(argv[i] + 5)) {
+                if (name != "tight" && name != "padded") {
+                    std::cerr << "Unknown leading dimension '" << name << "' (use tight or padded)\n";
+                    return 1;
+                }
+                padded_lds.push_back(name == "padded");
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--backend=", 10) == 0) {
+            if (!parse_exec_backend(argv[i] + 10, &backend)) {
+                std::cerr << "Unknown backend '" << (argv[i] + 10) << "' (use omp or pool)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--pin=", 6) == 0) {
+            if (!parse_pin_policy(argv[i] + 6, &pin)) {
+                std::cerr << "Unknown pin policy '" << (argv[i] + 6) << "' (use none, compact, scatter or smt)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--pages=", 8) == 0) {
+            page_backend_t pages;
+            if (!parse_page_backend(argv[i] + 8, &pages)) {
+                std::cerr << "Unknown page backend '" << (argv[i] + 8) << "' (use default, thp, 2m or 1g)\n";
+                return 1;
+            }
+            set_page_backend(pages);
+            continue;
+        }
+        std::cerr << "Unknown option '" << argv[i] << "'\n";
+        return 1;
+    }
+
+    std::vector<std::pair<dim_t, dim_t>> shapes;
+    for (const std::string& text : shape_list) {
+        size_t x = text.find('x');
+        size_t m = 0, n = 0;
+        if (x == std::string::npos || !parse_count(text.substr(0, x), &m) || !parse_count(text.substr(x + 1), &n)) {
+            std::cerr << "Invalid shape '" << text << "' (use <rows>x<cols>)\n";
+            return 1;
+        }
+        shapes.push_back({ m, n });
+    }
+    std::vector<int> thread_counts;
+    if (thread_list.empty()) thread_list.push_back(std::to_string(get_num_threads()));
+    for (const std::string& text : thread_list) {
+        int threads = std::atoi(text.c_str());
+        if (threads < 1) {
+            std::cerr << "Invalid thread count '" << text << "'\n";
+            return 1;
+        }
+        thread_counts.push_back(threads);
+    }
+
+    std::ofstream csv;
+    if (!open_csv(csv, RESULTS_PATH,
+                  "kernel,rows,cols,ld,ld_mode,threads,split,m_way,n_way,auto_grid,time,min,p90,cv,runs,kernel_time,gbps,vs_rows,vs_rows_significant,shared_lines,contended_bytes,backend,pin,pages")) {
+        std::cerr << "Cannot write results '" << RESULTS_PATH << "'\n";
+        return 1;
+    }
+
+    std::cout << "🧮 Matrix Split Benchmark\n";
+    std::cout << "🔀 Backend: " << exec_backend_name(backend) << ", pinning: " << pin_policy_name(pin) << "\n";
+
+    for (const auto& shape : shapes) {
+        for (bool padded : padded_lds) {
+            matrices_t mat;
+            mat.m = shape.first;
+            mat.n = shape.second;
+            mat.ld = padded ? padded_leading_dim(mat.n, sizeof(float), CACHE_LINE_SIZE) : mat.n;
+            mat.A = allocate_aligned_buffer<float>(mat.m * mat.ld);
+            mat.B = allocate_aligned_buffer<float>(mat.m * mat.ld);
+            mat.C = allocate_aligned_buffer<float>(mat.m * mat.ld);
+            mat.x.assign(mat.m, 1.0f);
+            mat.y.assign(mat.n, 1.0f);
+            std::fill(mat.A, mat.A + mat.m * mat.ld, 1.0f);
+            std::fill(mat.B, mat.B + mat.m * mat.ld, 2.0f);
+            const char* ld_mode = padded ? "padded" : "tight";
+
+            std::cout << "\n📐 " << mat.m << " x " << mat.n << ", ld " << mat.ld << " (" << ld_mode << ", rows "
+                      << (mat.ld * sizeof(float) % CACHE_LINE_SIZE ? "not " : "") << "line aligned)\n";
+            print_page_report("Matrix C", mat.C, mat.m * mat.ld * sizeof(float));
+
+            for (int num_threads : thread_counts) {
+                ParallelExecutor exec(backend, num_threads, pin_policy_cpus(pin, num_threads));
+                for (matrix_kernel_t kernel : kernels) {
+                    // Loads and stores of C, plus A and B for the add
+                    double bytes_moved = (kernel == MATRIX_ADD ? 3.0 : 2.0) * mat.m * mat.n * sizeof(float);
+                    measure_stats_t rows = {};
+                    for (const strategy_t& s : strategies(num_threads, mat.m, mat.n)) {
+                        std::fill(mat.C, mat.C + mat.m * mat.ld, 0.0f);
+                        std::vector<double> kernel_times;
+                        measure_stats_t time = measure(config, [&](int run) {
+                            auto start = std::chrono::steady_clock::now();
+                            double kernel_time = matrix_update(kernel, s, mat, exec);
+                            auto end = std::chrono::steady_clock::now();
+                            if (run >= 0) kernel_times.push_back(kernel_time);
+                            return std::chrono::duration<double>(end - start).count();
+                        });
+                        measure_stats_t kernel_time = summarize_samples(kernel_times);
+                        if (!check_result(kernel, mat)) return 1;
+
+                        false_sharing_report_t sharing = find_false_sharing(s, mat, num_threads);
+                        if (s.split == SPLIT_ROWS) rows = time;
+                        bool significant = stats_differ(rows, time);
+                        double gbps = bytes_moved / time.median / 1e9;
+
+                        std::cout << (sharing.shared.empty() ? "✅ " : "⚠️  ") << matrix_kernel_name(kernel) << " "
+                                  << num_threads << " threads, " << split_name(s.split) << " " << s.m_way << "x" << s.n_way
+                                  << (s.is_auto ? " (auto)" : "") << ": " << time.median << " sec, " << gbps << " GB/s, "
+                                  << rows.median / time.median << "x vs rows"
+                                  << (s.split == SPLIT_ROWS || significant ? "" : " (within noise)")
+                                  << ", " << sharing.total_lines << " shared lines"
+                                  << " (CV " << time.cv * 100.0 << "%, " << time.runs << " runs)\n";
+
+                        csv << matrix_kernel_name(kernel) << "," << mat.m << "," << mat.n << "," << mat.ld << "," << ld_mode << ","
+                            << num_threads << "," << split_name(s.split) << "," << s.m_way << "," << s.n_way << "," << s.is_auto << ","
+                            << time.median << "," << time.min << "," << time.p90 << "," << time.cv << "," << time.runs << ","
+                            << kernel_time.median << "," << gbps << "," << rows.median / time.median << "," << significant << ","
+                            << sharing.total_lines << "," << sharing.total_bytes << "," << exec_backend_name(backend) << ","
+                            << pin_policy_name(pin) << "," << page_backend_name(used_page_backend()) << "\n";
+
+                        JsonRecord record;
+                        record.add("benchmark", "matrix")
+                              .add("kernel", matrix_kernel_name(kernel))
+                              .add("rows", static_cast<long long>(mat.m))
+                              .add("cols", static_cast<long long>(mat.n))
+                              .add("ld", static_cast<long long>(mat.ld))
+                              .add("ld_mode", ld_mode)
+                              .add("threads", num_threads)
+                              .add("split", split_name(s.split))
+                              .add("m_way", static_cast<long long>(s.m_way))
+                              .add("n_way", static_cast<long long>(s.n_way))
+                              .add("backend", exec_backend_name(backend))
+                              .add("pin", pin_policy_name(pin))
+                              .add("pages", page_backend_name(used_page_backend()));
+
+                        JsonRecord result;
+                        result.add("time", time)
+                              .add("kernel_time", kernel_time)
+                              .add("gbps", gbps)
+                              .add("shared_lines", static_cast<long long>(sharing.total_lines));
+                        store_result(MEASUREMENTS_PATH, record, result);
+                    }
+                }
+            }
+
+            free_aligned_buffer(mat.A);
+            free_aligned_buffer(mat.B);
+            free_aligned_buffer(mat.C);
+        }
+    }
+    return 0;
+}
+// g++ -fopenmp -O3 -march=native -std=c++17 matrix_benchmark.cpp benchmark_common.cpp thread_utils.cpp thread_pool.cpp numa_placement.cpp perf_counters.cpp write_tracker.cpp timeline.cpp measurement.cpp result_store.cpp cache_info.cpp false_sharing.cpp huge_pages.cpp -o matrix_benchmark
+// ./matrix_benchmark [--shapes=1000x1000,100x10000] [--threads=2,4,8] [--kernels=add,rank1] [--ld=tight,padded] [--backend=pool] [--pin=compact]
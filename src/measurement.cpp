@@ -0,0 +1,246 @@
+#include "measurement.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Two-sided 95% Student t critical values for 1..30 degrees of freedom
+static const double T95[30] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static double t95(int dof)
+{
+	if (dof < 1) return 0.0;
+	if (dof <= 30) return T95[dof - 1];
+	return 1.96 + 2.4 / dof; // close to the table at 30, tends to the normal value
+}
+
+// Linear interpolation between the closest ranks of sorted samples
+static double percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty()) return 0.0;
+	double pos = p * (sorted.size() - 1);
+	size_t lo  = static_cast<size_t>(pos);
+	size_t hi  = std::min(lo + 1, sorted.size() - 1);
+	return sorted[lo] + (pos - lo) * (sorted[hi] - sorted[lo]);
+}
+
+measure_config_t default_measure_config()
+{
+	measure_config_t config;
+	config.min_runs         = 5;
+	config.max_runs         = 10000;
+	config.target_ci        = 0.01;
+	config.time_budget      = 2.0;
+	config.max_warmup_runs  = 50;
+	config.warmup_tolerance = 0.05;
+	return config;
+}
+
+bool parse_measure_option(const char* arg, measure_config_t* config)
+{
+	const char* value;
+	if (std::strncmp(arg, "--ci=", 5) == 0) {
+		value = arg + 5;
+		config->target_ci = std::atof(value);
+		if (config->target_ci > 0.0) return true;
+	} else if (std::strncmp(arg, "--budget=", 9) == 0) {
+		value = arg + 9;
+		config->time_budget = std::atof(value);
+		if (config->time_budget > 0.0) return true;
+	} else if (std::strncmp(arg, "--min-runs=", 11) == 0) {
+		value = arg + 11;
+		config->min_runs = std::atoi(value);
+		if (config->min_runs >= 2) return true;
+	} else if (std::strncmp(arg, "--max-runs=", 11) == 0) {
+		value = arg + 11;
+		config->max_runs = std::atoi(value);
+		if (config->max_runs >= 2) return true;
+	} else {
+		return false;
+	}
+	std::cerr << "Invalid value in '" << arg << "' (--ci and --budget need a positive number, "
+	          << "--min-runs and --max-runs at least 2)\n";
+	std::exit(1);
+}
+
+measure_stats_t summarize_samples(std::vector<double> samples)
+{
+	measure_stats_t stats;
+	std::memset(&stats, 0, sizeof(stats));
+	stats.runs = static_cast<int>(samples.size());
+	if (samples.empty()) return stats;
+
+	std::sort(samples.begin(), samples.end());
+	double sum = 0.0;
+	for (double s : samples) sum += s;
+	stats.mean = sum / samples.size();
+
+	double sq = 0.0;
+	for (double s : samples) sq += (s - stats.mean) * (s - stats.mean);
+	stats.stddev = samples.size() > 1 ? std::sqrt(sq / (samples.size() - 1)) : 0.0;
+	stats.cv     = stats.mean > 0.0 ? stats.stddev / stats.mean : 0.0;
+	stats.ci95   = t95(stats.runs - 1) * stats.stddev / std::sqrt(static_cast<double>(samples.size()));
+
+	stats.min    = samples.front();
+	stats.max    = samples.back();
+	stats.median = percentile(samples, 0.50);
+	stats.p90    = percentile(samples, 0.90);
+	stats.p99    = percentile(samples, 0.99);
+
+	double q1  = percentile(samples, 0.25);
+	double q3  = percentile(samples, 0.75);
+	double iqr = q3 - q1;
+	for (double s : samples)
+		if (s < q1 - 3.0 * iqr || s > q3 + 3.0 * iqr) ++stats.outliers;
+	return stats;
+}
+
+bool stats_differ(const measure_stats_t& a, const measure_stats_t& b)
+{
+	return std::fabs(a.mean - b.mean) > a.ci95 + b.ci95;
+}
+
+measure_stats_t measure_impl(const measure_config_t& config, double (*call)(void*, int), void* ctx)
+{
+	auto   begin   = std::chrono::steady_clock::now();
+	auto   elapsed = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(); };
+
+	// Warm caches, TLBs, page tables and the thread team until two
+	// consecutive runs agree; never spend more than a quarter of the budget
+	int    warmup_runs = 0;
+	double previous    = -1.0;
+	while (warmup_runs < config.max_warmup_runs) {
+		double t = call(ctx, -1);
+		++warmup_runs;
+		if (previous > 0.0 && std::fabs(t - previous) <= config.warmup_tolerance * previous) break;
+		if (elapsed() > 0.25 * config.time_budget) break;
+		previous = t;
+	}
+
+	std::vector<double> samples;
+	bool converged = false;
+	for (int run = 0; run < config.max_runs; ++run) {
+		samples.push_back(call(ctx, run));
+		if (run + 1 < config.min_runs) continue;
+
+		// Running mean and CI; the full summary is only computed at the end
+		double sum = 0.0, sq = 0.0;
+		for (double s : samples) sum += s;
+		double mean = sum / samples.size();
+		for (double s : samples) sq += (s - mean) * (s - mean);
+		double ci = t95(run) * std::sqrt(sq / run) / std::sqrt(static_cast<double>(samples.size()));
+		if (ci <= config.target_ci * mean) { converged = true; break; }
+		if (elapsed() > config.time_budget) break;
+	}
+
+	measure_stats_t stats = summarize_samples(samples);
+	stats.warmup_runs = warmup_runs;
+	stats.converged   = converged;
+	return stats;
+}
+
+void JsonRecord::key(const char* key)
+{
+	if (!body_.empty()) body_ += ",";
+	body_ += "\"";
+	body_ += key;
+	body_ += "\":";
+}
+
+JsonRecord& JsonRecord::add(const char* key, const std::string& value)
+{
+	this->key(key);
+	body_ += "\"";
+	for (char c : value) {
+		switch (c) {
+			case '"':  body_ += "\\\""; break;
+			case '\\': body_ += "\\\\"; break;
+			case '\n': body_ += "\\n";  break;
+			case '\t': body_ += "\\t";  break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char buf[8];
+					std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+					body_ += buf;
+				} else {
+					body_ += c;
+				}
+		}
+	}
+	body_ += "\"";
+	return *this;
+}
+
+JsonRecord& JsonRecord::add(const char* key, const char* value)
+{
+	return add(key, std::string(value));
+}
+
+JsonRecord& JsonRecord::add(const char* key, double value)
+{
+	this->key(key);
+	// JSON has no NaN or Inf
+	if (!std::isfinite(value)) {
+		body_ += "null";
+		return *this;
+	}
+	char buf[32];
+	std::snprintf(buf, sizeof(buf), "%.9g", value);
+	body_ += buf;
+	return *this;
+}
+
+JsonRecord& JsonRecord::add(const char* key, long long value)
+{
+	this->key(key);
+	body_ += std::to_string(value);
+	return *this;
+}
+
+JsonRecord& JsonRecord::add(const char* key, bool value)
+{
+	this->key(key);
+	body_ += value ? "true" : "false";
+	return *this;
+}
+
+JsonRecord& JsonRecord::add(const char* key, const measure_stats_t& stats)
+{
+	JsonRecord nested;
+	nested.add("warmup_runs", stats.warmup_runs)
+	      .add("runs", stats.runs)
+	      .add("converged", stats.converged)
+	      .add("outliers", stats.outliers)
+	      .add("mean", stats.mean)
+	      .add("stddev", stats.stddev)
+	      .add("cv", stats.cv)
+	      .add("ci95", stats.ci95)
+	      .add("min", stats.min)
+	      .add("median", stats.median)
+	      .add("p90", stats.p90)
+	      .add("p99", stats.p99)
+	      .add("max", stats.max);
+	return add(key, nested);
+}
+
+JsonRecord& JsonRecord::add(const char* key, const JsonRecord& nested)
+{
+	this->key(key);
+	body_ += nested.str();
+	return *this;
+}
+
+void append_json_record(const char* path, const JsonRecord& record)
+{
+	std::ofstream out(path, std::ios::app);
+	out << record.str() << "\n";
+}
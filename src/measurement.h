@@ -0,0 +1,94 @@
+#ifndef MEASUREMENT_H
+#define MEASUREMENT_H
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// When to stop warming up and repeating a measurement
+struct measure_config_t
+{
+	int    min_runs;          // measured runs before the CI is checked
+	int    max_runs;          // hard limit on measured runs
+	double target_ci;         // stop when the 95% CI half-width is below this fraction of the mean
+	double time_budget;       // seconds per configuration, warmup included
+	int    max_warmup_runs;
+	double warmup_tolerance;  // warm when two consecutive runs differ by less than this fraction
+};
+
+// Summary of the measured runs (warmup excluded), in seconds
+struct measure_stats_t
+{
+	int    warmup_runs;
+	int    runs;
+	bool   converged;   // target_ci reached before the budget or max_runs ran out
+	int    outliers;    // samples beyond 3 IQR of the quartiles (kept in the stats)
+	double mean;
+	double stddev;
+	double cv;          // stddev / mean
+	double ci95;        // half-width of the 95% confidence interval of the mean
+	double min;
+	double median;
+	double p90;
+	double p99;
+	double max;
+};
+
+// 5..10000 runs, 1% CI, 2 s budget, up to 50 warmup runs within 5%
+measure_config_t default_measure_config();
+
+// Apply --ci=<fraction>, --budget=<sec>, --min-runs=<n> or --max-runs=<n>.
+// Returns false if arg is not a measurement option; exits on bad values.
+bool parse_measure_option(const char* arg, measure_config_t* config);
+
+// Statistics of a set of samples (need not be sorted)
+measure_stats_t summarize_samples(std::vector<double> samples);
+
+// True if the 95% confidence intervals of the two means do not overlap,
+// i.e. the difference between a and b is unlikely to be noise
+bool stats_differ(const measure_stats_t& a, const measure_stats_t& b);
+
+measure_stats_t measure_impl(const measure_config_t& config, double (*call)(void*, int), void* ctx);
+
+// Run fn(run) until the timing is stable. Warmup calls get run = -1 and
+// stop once two consecutive calls agree within warmup_tolerance; measured
+// calls get run = 0, 1, ... and stop once the CI target, max_runs or the
+// time budget is reached, but never before min_runs. fn returns the time
+// of the call in seconds.
+template <typename F>
+measure_stats_t measure(const measure_config_t& config, F&& fn)
+{
+	typedef typename std::remove_reference<F>::type fn_t;
+	return measure_impl(config,
+	                    [](void* ctx, int run) { return static_cast<double>((*static_cast<fn_t*>(ctx))(run)); },
+	                    &fn);
+}
+
+// One line of JSON (JSON Lines) describing a measured configuration
+class JsonRecord
+{
+public:
+	JsonRecord& add(const char* key, const std::string& value);
+	JsonRecord& add(const char* key, const char* value);
+	JsonRecord& add(const char* key, double value);
+	JsonRecord& add(const char* key, long long value);
+	JsonRecord& add(const char* key, int value) { return add(key, static_cast<long long>(value)); }
+	JsonRecord& add(const char* key, size_t value) { return add(key, static_cast<long long>(value)); }
+	JsonRecord& add(const char* key, bool value);
+	// Nested object with every field of the stats
+	JsonRecord& add(const char* key, const measure_stats_t& stats);
+	// Nested object
+	JsonRecord& add(const char* key, const JsonRecord& nested);
+
+	std::string str() const { return "{" + body_ + "}"; }
+
+private:
+	void key(const char* key);
+
+	std::string body_;
+};
+
+// Append a record to a JSON Lines file
+void append_json_record(const char* path, const JsonRecord& record);
+
+#endif // MEASUREMENT_H
@@ -0,0 +1,266 @@
+#include "numa_placement.h"
+#include "thread_utils.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Size of the node masks passed to the kernel, in bits
+#define MAX_NUMA_NODES 1024
+
+// Parse sysfs cpu/node lists such as "0-3,8-11"
+static std::vector<int> parse_id_list(const std::string& list)
+{
+	std::vector<int> ids;
+	std::size_t pos = 0;
+	while (pos < list.size()) {
+		std::size_t comma = list.find(',', pos);
+		if (comma == std::string::npos) comma = list.size();
+		std::string item = list.substr(pos, comma - pos);
+		std::size_t dash = item.find('-');
+		if (!item.empty()) {
+			int lo = std::atoi(item.c_str());
+			int hi = dash == std::string::npos ? lo : std::atoi(item.c_str() + dash + 1);
+			for (int id = lo; id <= hi; ++id) ids.push_back(id);
+		}
+		pos = comma + 1;
+	}
+	return ids;
+}
+
+static std::string read_line(const std::string& path)
+{
+	std::ifstream in(path);
+	std::string line;
+	std::getline(in, line);
+	return line;
+}
+
+static int read_int(const std::string& path, int fallback)
+{
+	std::string line = read_line(path);
+	return line.empty() ? fallback : std::atoi(line.c_str());
+}
+
+std::vector<int> online_numa_nodes()
+{
+	std::vector<int> nodes = parse_id_list(read_line("/sys/devices/system/node/online"));
+	if (nodes.empty()) nodes.push_back(0);
+	return nodes;
+}
+
+std::vector<cpu_topology_t> query_cpu_topology()
+{
+	std::map<int, int> cpu_node;
+	for (int node : online_numa_nodes()) {
+		std::string list = read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+		for (int cpu : parse_id_list(list)) cpu_node[cpu] = node;
+	}
+
+	std::vector<cpu_topology_t> topology;
+	for (int cpu : available_cpus()) {
+		std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+		cpu_topology_t t;
+		t.cpu     = cpu;
+		t.package = read_int(dir + "physical_package_id", 0);
+		t.core    = read_int(dir + "core_id", cpu);
+		t.node    = cpu_node.count(cpu) ? cpu_node[cpu] : 0;
+		topology.push_back(t);
+	}
+	return topology;
+}
+
+std::vector<int> pin_policy_cpus(pin_policy_t policy, int num_threads)
+{
+	std::vector<int> cpus;
+	if (policy == PIN_NONE) return cpus;
+
+	// cores[package][core_id] = hardware threads of that core
+	std::map<int, std::map<int, std::vector<int>>> cores;
+	for (const cpu_topology_t& t : query_cpu_topology())
+		cores[t.package][t.core].push_back(t.cpu);
+
+	// siblings[package][core index] = hardware threads in cpu order
+	std::vector<std::vector<std::vector<int>>> siblings;
+	std::size_t max_smt = 0;
+	for (auto& package : cores) {
+		siblings.emplace_back();
+		for (auto& core : package.second) {
+			std::sort(core.second.begin(), core.second.end());
+			siblings.back().push_back(core.second);
+			max_smt = std::max(max_smt, core.second.size());
+		}
+	}
+
+	std::vector<int> order;
+	if (policy == PIN_SMT) {
+		for (auto& package : siblings)
+			for (auto& core : package)
+				for (int cpu : core) order.push_back(cpu);
+	} else {
+		// One thread per physical core first; SMT siblings only once every
+		// core has one thread.
+		for (std::size_t smt = 0; smt < max_smt; ++smt) {
+			if (policy == PIN_COMPACT) {
+				for (auto& package : siblings)
+					for (auto& core : package)
+						if (smt < core.size()) order.push_back(core[smt]);
+			} else { // PIN_SCATTER
+				std::size_t max_cores = 0;
+				for (auto& package : siblings) max_cores = std::max(max_cores, package.size());
+				for (std::size_t c = 0; c < max_cores; ++c)
+					for (auto& package : siblings)
+						if (c < package.size() && smt < package[c].size()) order.push_back(package[c][smt]);
+			}
+		}
+	}
+
+	for (int i = 0; i < num_threads; ++i) cpus.push_back(order[i % order.size()]);
+	return cpus;
+}
+
+bool parse_pin_policy(const char* name, pin_policy_t* policy)
+{
+	for (int i = PIN_NONE; i <= PIN_SMT; ++i) {
+		if (std::strcmp(name, pin_policy_name(static_cast<pin_policy_t>(i))) == 0) {
+			*policy = static_cast<pin_policy_t>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* pin_policy_name(pin_policy_t policy)
+{
+	switch (policy) {
+		case PIN_COMPACT: return "compact";
+		case PIN_SCATTER: return "scatter";
+		case PIN_SMT:     return "smt";
+		default:          return "none";
+	}
+}
+
+bool parse_mem_policy(const char* name, mem_policy_t* policy, int* node)
+{
+	*node = 0;
+	if (std::strcmp(name, "default") == 0)     { *policy = MEM_DEFAULT;     return true; }
+	if (std::strcmp(name, "first-touch") == 0) { *policy = MEM_FIRST_TOUCH; return true; }
+	if (std::strcmp(name, "interleave") == 0)  { *policy = MEM_INTERLEAVE;  return true; }
+	if (std::strncmp(name, "bind:", 5) == 0 && name[5] != '\0') {
+		*policy = MEM_BIND;
+		*node = std::atoi(name + 5);
+		return *node >= 0 && *node < MAX_NUMA_NODES;
+	}
+	return false;
+}
+
+const char* mem_policy_name(mem_policy_t policy)
+{
+	switch (policy) {
+		case MEM_FIRST_TOUCH: return "first-touch";
+		case MEM_INTERLEAVE:  return "interleave";
+		case MEM_BIND:        return "bind";
+		default:              return "default";
+	}
+}
+
+// Kernel mode and node mask for a policy
+static int policy_mode(mem_policy_t policy, int node, unsigned long* mask)
+{
+	std::memset(mask, 0, MAX_NUMA_NODES / 8);
+	if (policy == MEM_INTERLEAVE) {
+		for (int n : online_numa_nodes()) mask[n / 64] |= 1UL << (n % 64);
+		return MPOL_INTERLEAVE;
+	}
+	if (policy == MEM_BIND) {
+		mask[node / 64] |= 1UL << (node % 64);
+		return MPOL_BIND;
+	}
+	return MPOL_DEFAULT;
+}
+
+bool apply_mem_policy(void* addr, std::size_t bytes, mem_policy_t policy, int node)
+{
+	if (policy != MEM_INTERLEAVE && policy != MEM_BIND) return true;
+
+	unsigned long mask[MAX_NUMA_NODES / 64];
+	int mode = policy_mode(policy, node, mask);
+
+	uintptr_t page  = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+	uintptr_t start = reinterpret_cast<uintptr_t>(addr) & ~(page - 1);
+	uintptr_t end   = (reinterpret_cast<uintptr_t>(addr) + bytes + page - 1) & ~(page - 1);
+
+	// maxnode counts one past the last bit the kernel should read
+	if (syscall(SYS_mbind, start, end - start, mode, mask, MAX_NUMA_NODES + 1, MPOL_MF_MOVE) != 0) {
+		std::fprintf(stderr, "mbind(%s) failed: %s\n", mem_policy_name(policy), std::strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+bool discard_pages(void* addr, std::size_t bytes, std::size_t page_bytes)
+{
+	// Only whole pages: the partial ones at the ends may hold other data
+	uintptr_t page  = page_bytes ? page_bytes : static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+	uintptr_t start = (reinterpret_cast<uintptr_t>(addr) + page - 1) & ~(page - 1);
+	uintptr_t end   = (reinterpret_cast<uintptr_t>(addr) + bytes) & ~(page - 1);
+	if (end <= start) return true;
+
+	if (madvise(reinterpret_cast<void*>(start), end - start, MADV_DONTNEED) != 0) {
+		std::fprintf(stderr, "madvise(MADV_DONTNEED) failed: %s\n", std::strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+bool set_thread_mem_policy(mem_policy_t policy, int node)
+{
+	unsigned long mask[MAX_NUMA_NODES / 64];
+	int mode = policy_mode(policy, node, mask);
+
+	long rc = mode == MPOL_DEFAULT ? syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0)
+	                               : syscall(SYS_set_mempolicy, mode, mask, MAX_NUMA_NODES + 1);
+	if (rc != 0) {
+		std::fprintf(stderr, "set_mempolicy(%s) failed: %s\n", mem_policy_name(policy), std::strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+std::vector<std::size_t> pages_per_node(const void* addr, std::size_t bytes, std::size_t max_samples)
+{
+	std::vector<std::size_t> counts;
+	if (bytes == 0 || max_samples == 0) return counts;
+
+	uintptr_t page  = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+	uintptr_t start = reinterpret_cast<uintptr_t>(addr) & ~(page - 1);
+	uintptr_t end   = reinterpret_cast<uintptr_t>(addr) + bytes;
+	std::size_t num_pages = (end - start + page - 1) / page;
+	std::size_t stride = num_pages > max_samples ? num_pages / max_samples : 1;
+
+	std::vector<void*> pages;
+	for (std::size_t p = 0; p < num_pages; p += stride)
+		pages.push_back(reinterpret_cast<void*>(start + p * page));
+	std::vector<int> status(pages.size(), -1);
+
+	// With a null node list move_pages only reports where each page lives
+	if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0)
+		return counts;
+
+	for (int node : status) {
+		if (node < 0) continue; // not resident yet
+		if (static_cast<std::size_t>(node) >= counts.size()) counts.resize(node + 1, 0);
+		++counts[node];
+	}
+	return counts;
+}
@@ -0,0 +1,74 @@
+#ifndef NUMA_PLACEMENT_H
+#define NUMA_PLACEMENT_H
+
+#include <cstddef>
+#include <vector>
+
+// Where consecutive work_ids are pinned
+enum pin_policy_t
+{
+	PIN_NONE = 0,   // leave placement to the runtime (pool: allowed CPUs in order)
+	PIN_COMPACT,    // one thread per physical core, filling socket 0 first
+	PIN_SCATTER,    // one thread per physical core, alternating sockets
+	PIN_SMT         // neighbouring work_ids on SMT siblings of the same core
+};
+
+// Where the pages of the benchmark buffers are placed
+enum mem_policy_t
+{
+	MEM_DEFAULT = 0,   // serial initialization: every page on the main thread's node
+	MEM_FIRST_TOUCH,   // parallel initialization following thread_block_partition()
+	MEM_INTERLEAVE,    // pages round-robin over all online nodes
+	MEM_BIND           // all pages on one explicit node
+};
+
+struct cpu_topology_t
+{
+	int cpu;
+	int package;
+	int core;
+	int node;
+};
+
+// Topology of the CPUs the process may run on (from sysfs)
+std::vector<cpu_topology_t> query_cpu_topology();
+
+// Online NUMA node ids; {0} on machines without NUMA information
+std::vector<int> online_numa_nodes();
+
+// CPU for each work_id 0..num_threads-1; empty for PIN_NONE. Wraps around
+// when there are more threads than CPUs.
+std::vector<int> pin_policy_cpus(pin_policy_t policy, int num_threads);
+
+bool parse_pin_policy(const char* name, pin_policy_t* policy);
+const char* pin_policy_name(pin_policy_t policy);
+
+// Parse "default", "first-touch", "interleave" or "bind:<node>"
+bool parse_mem_policy(const char* name, mem_policy_t* policy, int* node);
+const char* mem_policy_name(mem_policy_t policy);
+
+// Apply MEM_INTERLEAVE / MEM_BIND to an existing range with mbind(2),
+// migrating pages that were already touched. The range is widened to page
+// boundaries. No-op for the other policies. Prints the reason and returns
+// false if the kernel rejects the policy.
+bool apply_mem_policy(void* addr, std::size_t bytes, mem_policy_t policy, int node);
+
+// Drop the whole page_bytes pages inside [addr, addr + bytes) with
+// madvise(MADV_DONTNEED), so the next touch of each one places it again
+// under the policy of the touching thread; this is how a reused buffer is
+// first-touched again. Dropped pages read as zero. page_bytes is the page
+// size of the mapping (0 for the base page size): a THP range that is not
+// whole huge pages splits them, and hugetlbfs rejects it. Prints the reason
+// and returns false if the kernel refuses (hugetlbfs before Linux 5.18).
+bool discard_pages(void* addr, std::size_t bytes, std::size_t page_bytes = 0);
+
+// Set the default policy of the calling thread with set_mempolicy(2), so
+// pages it touches later follow MEM_INTERLEAVE / MEM_BIND; every other
+// policy restores the system default.
+bool set_thread_mem_policy(mem_policy_t policy, int node);
+
+// Number of resident pages of [addr, addr + bytes) on each node, indexed by
+// node id, from a sample of at most max_samples pages (move_pages(2) query).
+std::vector<std::size_t> pages_per_node(const void* addr, std::size_t bytes, std::size_t max_samples = 4096);
+
+#endif // NUMA_PLACEMENT_H
@@ -0,0 +1,243 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include "thread_utils.h"
+#include "thread_pool.h"
+#include "numa_placement.h"
+#include "measurement.h"
+#include "result_store.h"
+#include "benchmark_common.h"
+
+#define DEFAULT_OPS (1 << 22)      // Operations per thread and run
+#define INPUT_SIZE 4096            // Reduction input, reread from L1
+
+// What the compiler thinks separates two objects that must not false
+// share; 64 on x86-64 for GCC
+#ifdef __cpp_lib_hardware_interference_size
+#define INTERFERENCE_SIZE std::hardware_destructive_interference_size
+#else
+#define INTERFERENCE_SIZE 64
+#endif
+
+// Per-thread state under test
+enum workload_t {
+    WORKLOAD_REDUCTION,   // double accumulator updated in memory for every element
+    WORKLOAD_ATOMIC       // std::atomic<long long> counter, relaxed fetch_add
+};
+
+const char* workload_name(workload_t workload) {
+    return workload == WORKLOAD_ATOMIC ? "atomic_counter" : "reduction";
+}
+
+// How the per-thread slots are laid out, i.e. the Align of PerThread<T, Align>
+enum layout_t {
+    LAYOUT_PACKED,        // alignof(T): neighbouring threads share lines
+    LAYOUT_ALIGN64,       // alignas(64)
+    LAYOUT_INTERFERENCE,  // std::hardware_destructive_interference_size
+    LAYOUT_PAD128         // two lines, defeats the adjacent-line prefetcher
+};
+
+const char* layout_name(layout_t layout) {
+    switch (layout) {
+        case LAYOUT_ALIGN64:      return "align64";
+        case LAYOUT_INTERFERENCE: return "interference";
+        case LAYOUT_PAD128:       return "pad128";
+        default:                  return "packed";
+    }
+}
+
+// Every thread adds the whole input ops times over into its own slot. The
+// volatile access keeps the accumulator in memory, as a results struct
+// shared with other threads would be. check receives the combined sum.
+template <std::size_t Align>
+measure_stats_t run_reduction(ParallelExecutor& exec, const double* input, long long ops,
+                              const measure_config_t& config, double* check, std::size_t* stride) {
+    PerThread<double, Align> acc(exec.num_threads());
+    *stride = acc.stride();
+    measure_stats_t stats = measure(config, [&](int) {
+        auto start = std::chrono::steady_clock::now();
+        exec.run([&](int work_id, int) {
+            volatile double& slot = acc[work_id];
+            slot = 0.0;
+            for (long long i = 0; i < ops; ++i) slot = slot + input[i & (INPUT_SIZE - 1)];
+        });
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    });
+    *check = acc.combine(0.0, [](double a, double b) { return a + b; });
+    return stats;
+}
+
+// Every thread increments its own atomic counter ops times; check
+// receives the total count of the last run
+template <std::size_t Align>
+measure_stats_t run_atomic(ParallelExecutor& exec, long long ops, const measure_config_t& config,
+                           double* check, std::size_t* stride) {
+    PerThread<std::atomic<long long>, Align> counters(exec.num_threads());
+    *stride = counters.stride();
+    measure_stats_t stats = measure(config, [&](int) {
+        auto start = std::chrono::steady_clock::now();
+        exec.run([&](int work_id, int) {
+            std::atomic<long long>& counter = counters[work_id];
+            counter.store(0, std::memory_order_relaxed);
+            for (long long i = 0; i < ops; ++i) counter.fetch_add(1, std::memory_order_relaxed);
+        });
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    });
+    long long total = 0;
+    for (int t = 0; t < counters.size(); ++t) total += counters[t].load();
+    *check = static_cast<double>(total);
+    return stats;
+}
+
+// Dispatch on the layout; each layout is its own instantiation
+measure_stats_t run_workload(workload_t workload, layout_t layout, ParallelExecutor& exec, const double* input,
+                             long long ops, const measure_config_t& config, double* check, std::size_t* stride) {
+    if (workload == WORKLOAD_ATOMIC) {
+        switch (layout) {
+            case LAYOUT_ALIGN64:      return run_atomic<64>(exec, ops, config, check, stride);
+            case LAYOUT_INTERFERENCE: return run_atomic<INTERFERENCE_SIZE>(exec, ops, config, check, stride);
+            case LAYOUT_PAD128:       return run_atomic<128>(exec, ops, config, check, stride);
+            default:                  return run_atomic<alignof(std::atomic<long long>)>(exec, ops, config, check, stride);
+        }
+    }
+    switch (layout) {
+        case LAYOUT_ALIGN64:      return run_reduction<64>(exec, input, ops, config, check, stride);
+        case LAYOUT_INTERFERENCE: return run_reduction<INTERFERENCE_SIZE>(exec, input, ops, config, check, stride);
+        case LAYOUT_PAD128:       return run_reduction<128>(exec, input, ops, config, check, stride);
+        default:                  return run_reduction<alignof(double)>(exec, input, ops, config, check, stride);
+    }
+}
+
+int main(int argc, char** argv) {
+    begin_run(argc, argv);
+    int max_threads = get_num_threads();
+    long long ops = DEFAULT_OPS;
+    exec_backend_t backend = BACKEND_OMP;
+    pin_policy_t pin = PIN_NONE;
+    measure_config_t config = default_measure_config();
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (parse_measure_option(argv[i], &config)) continue;
+        if (std::strncmp(argv[i], "--ops=", 6) == 0) {
+            ops = std::atoll(argv[i] + 6);
+            if (ops <= 0) {
+                std::cerr << "Invalid operation count '" << (argv[i] + 6) << "' (must be > 0)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--backend=", 10) == 0) {
+            if (!parse_exec_backend(argv[i] + 10, &backend)) {
+                std::cerr << "Unknown backend '" << (argv[i] + 10) << "' (use omp or pool)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--pin=", 6) == 0) {
+            if (!parse_pin_policy(argv[i] + 6, &pin)) {
+                std::cerr << "Unknown pin policy '" << (argv[i] + 6) << "' (use none, compact, scatter or smt)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (positional == 0) max_threads = std::atoi(argv[i]);
+        ++positional;
+    }
+    if (max_threads < 1) {
+        std::cerr << "Invalid thread count " << max_threads << "\n";
+        return 1;
+    }
+
+    // 1, 2, 4, ... up to and including max_threads
+    std::vector<int> thread_counts;
+    for (int t = 1; t < max_threads; t *= 2) thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    // Each thread reads ops / INPUT_SIZE whole passes and then the first
+    // ops % INPUT_SIZE elements once more
+    std::vector<double> input(INPUT_SIZE);
+    double input_sum = 0.0;
+    double partial_sum = 0.0;
+    for (int i = 0; i < INPUT_SIZE; ++i) {
+        input[i] = 1.0 + (i % 100) * 0.01;
+        input_sum += input[i];
+        if (i < ops % INPUT_SIZE) partial_sum += input[i];
+    }
+
+    const char* path = "../data/per_thread_results.csv";
+    std::ofstream csv;
+    if (!open_csv(csv, path,
+                  "workload,layout,stride,threads,ops_per_thread,time,min,p90,cv,runs,mops,mops_per_thread,speedup_vs_packed,speedup_significant,backend,pin")) {
+        std::cerr << "Cannot write results '" << path << "'\n";
+        return 1;
+    }
+
+    std::cout << "🧮 Per-Thread State Benchmark\n";
+    std::cout << "🔄 " << ops << " operations per thread and run, threads up to " << max_threads << "\n";
+    std::cout << "📐 hardware_destructive_interference_size: " << INTERFERENCE_SIZE << " B\n";
+    std::cout << "🔀 Backend: " << exec_backend_name(backend) << ", pinning: " << pin_policy_name(pin) << "\n\n";
+
+    workload_t workloads[2] = { WORKLOAD_REDUCTION, WORKLOAD_ATOMIC };
+    layout_t layouts[4] = { LAYOUT_PACKED, LAYOUT_ALIGN64, LAYOUT_INTERFERENCE, LAYOUT_PAD128 };
+    for (int num_threads : thread_counts) {
+        ParallelExecutor exec(backend, num_threads, pin_policy_cpus(pin, num_threads));
+        std::cout << "🧵 " << num_threads << " threads\n";
+        for (workload_t workload : workloads) {
+            measure_stats_t packed = {};
+            for (layout_t layout : layouts) {
+                double check = 0.0;
+                std::size_t stride = 0;
+                measure_stats_t time = run_workload(workload, layout, exec, input.data(), ops, config, &check, &stride);
+                if (layout == LAYOUT_PACKED) packed = time;
+
+                // Same work in every layout, so a wrong total is a bug, not noise
+                double expected = workload == WORKLOAD_ATOMIC
+                                ? static_cast<double>(ops) * num_threads
+                                : (input_sum * (ops / INPUT_SIZE) + partial_sum) * num_threads;
+                if (check < expected * (1 - 1e-9) || check > expected * (1 + 1e-9)) {
+                    std::cerr << "❌ " << workload_name(workload) << " " << layout_name(layout)
+                              << ": total " << check << ", expected " << expected << "\n";
+                    return 1;
+                }
+
+                double mops = static_cast<double>(ops) * num_threads / time.median / 1e6;
+                bool significant = stats_differ(packed, time);
+                std::cout << (layout == LAYOUT_PACKED ? "⚠️  " : "✅ ") << workload_name(workload) << " "
+                          << layout_name(layout) << " (" << stride << " B/slot): " << mops << " Mops/s, "
+                          << mops / num_threads << " per thread, " << packed.median / time.median << "x vs packed"
+                          << (layout == LAYOUT_PACKED || significant ? "" : " (within noise)")
+                          << " (CV " << time.cv * 100.0 << "%, " << time.runs << " runs)\n";
+
+                csv << workload_name(workload) << "," << layout_name(layout) << "," << stride << "," << num_threads << ","
+                    << ops << "," << time.median << "," << time.min << "," << time.p90 << "," << time.cv << ","
+                    << time.runs << "," << mops << "," << mops / num_threads << "," << packed.median / time.median << ","
+                    << significant << "," << exec_backend_name(backend) << "," << pin_policy_name(pin) << "\n";
+
+                JsonRecord record;
+                record.add("benchmark", "per_thread")
+                      .add("kernel", workload_name(workload))
+                      .add("layout", layout_name(layout))
+                      .add("stride", stride)
+                      .add("threads", num_threads)
+                      .add("ops_per_thread", ops)
+                      .add("backend", exec_backend_name(backend))
+                      .add("pin", pin_policy_name(pin));
+
+                JsonRecord result;
+                result.add("time", time).add("mops", mops);
+                store_result(MEASUREMENTS_PATH, record, result);
+            }
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
+// g++ -fopenmp -O3 -march=native -std=c++17 per_thread_benchmark.cpp benchmark_common.cpp thread_utils.cpp thread_pool.cpp numa_placement.cpp perf_counters.cpp write_tracker.cpp timeline.cpp measurement.cpp result_store.cpp cache_info.cpp -o per_thread_benchmark
+// OMP_NUM_THREADS=8 ./per_thread_benchmark [max_threads] [--ops=N] [--backend=pool] [--pin=compact]
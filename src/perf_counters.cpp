@@ -0,0 +1,161 @@
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static long perf_event_open(perf_event_attr* attr, int group_fd)
+{
+	// pid 0, cpu -1: count the calling thread on whichever CPU it runs
+	return syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0);
+}
+
+static uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result)
+{
+	return cache | (op << 8) | (result << 16);
+}
+
+uint64_t default_hitm_config()
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_is("intel")) return 0x04d2;
+	return 0;
+}
+
+PerfCounters::PerfCounters(int num_threads, uint64_t hitm_config)
+	: hitm_config_(hitm_config), threads_(num_threads)
+{
+	for (thread_state_t& t : threads_) {
+		for (int e = 0; e < PERF_NUM_EVENTS; ++e) { t.fd[e] = -1; t.slot[e] = -1; }
+		t.leader = -1;
+		t.num_open = 0;
+	}
+	reset();
+}
+
+PerfCounters::~PerfCounters()
+{
+	for (thread_state_t& t : threads_)
+		for (int e = 0; e < PERF_NUM_EVENTS; ++e)
+			if (t.fd[e] >= 0) close(t.fd[e]);
+}
+
+bool PerfCounters::open_on_current_thread(int work_id)
+{
+	thread_state_t& t = threads_[work_id];
+
+	for (int e = 0; e < PERF_NUM_EVENTS; ++e) {
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size           = sizeof(attr);
+		attr.disabled       = t.leader < 0 ? 1 : 0; // siblings follow the leader
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+		attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		switch (e) {
+			case PERF_EV_CYCLES:
+				attr.type   = PERF_TYPE_HARDWARE;
+				attr.config = PERF_COUNT_HW_CPU_CYCLES;
+				break;
+			case PERF_EV_INSTRUCTIONS:
+				attr.type   = PERF_TYPE_HARDWARE;
+				attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+				break;
+			case PERF_EV_L1D_MISSES:
+				attr.type   = PERF_TYPE_HW_CACHE;
+				attr.config = cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+				break;
+			case PERF_EV_LLC_MISSES:
+				attr.type   = PERF_TYPE_HW_CACHE;
+				attr.config = cache_event(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+				break;
+			case PERF_EV_HITM:
+				if (hitm_config_ == 0) continue;
+				attr.type   = PERF_TYPE_RAW;
+				attr.config = hitm_config_;
+				break;
+		}
+
+		long fd = perf_event_open(&attr, t.leader);
+		if (fd < 0) {
+			std::lock_guard<std::mutex> lock(error_mutex_);
+			if (error_.empty())
+				error_ = std::string(event_name(static_cast<perf_event_id_t>(e))) + ": " + std::strerror(errno);
+			continue;
+		}
+		t.fd[e] = static_cast<int>(fd);
+		t.slot[e] = t.num_open++;
+		if (t.leader < 0) t.leader = t.fd[e];
+	}
+	return t.num_open > 0;
+}
+
+void PerfCounters::start(int work_id)
+{
+	thread_state_t& t = threads_[work_id];
+	if (t.leader < 0) return;
+	ioctl(t.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(t.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void PerfCounters::stop(int work_id)
+{
+	thread_state_t& t = threads_[work_id];
+	if (t.leader < 0) return;
+	ioctl(t.leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+	// Layout of a PERF_FORMAT_GROUP read: nr, time_enabled, time_running, values[nr]
+	uint64_t buf[3 + PERF_NUM_EVENTS];
+	if (read(t.leader, buf, sizeof(buf)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) return;
+
+	uint64_t enabled = buf[1];
+	uint64_t running = buf[2];
+	double scale = running > 0 ? static_cast<double>(enabled) / running : 0.0;
+	for (int e = 0; e < PERF_NUM_EVENTS; ++e)
+		if (t.slot[e] >= 0) t.counts.value[e] += buf[3 + t.slot[e]] * scale;
+}
+
+void PerfCounters::reset()
+{
+	for (thread_state_t& t : threads_)
+		for (int e = 0; e < PERF_NUM_EVENTS; ++e) t.counts.value[e] = 0.0;
+}
+
+bool PerfCounters::available(perf_event_id_t event) const
+{
+	for (const thread_state_t& t : threads_)
+		if (t.fd[event] < 0) return false;
+	return true;
+}
+
+bool PerfCounters::any_available() const
+{
+	for (int e = 0; e < PERF_NUM_EVENTS; ++e)
+		if (available(static_cast<perf_event_id_t>(e))) return true;
+	return false;
+}
+
+perf_counts_t PerfCounters::total() const
+{
+	perf_counts_t sum;
+	for (int e = 0; e < PERF_NUM_EVENTS; ++e) sum.value[e] = 0.0;
+	for (const thread_state_t& t : threads_)
+		for (int e = 0; e < PERF_NUM_EVENTS; ++e) sum.value[e] += t.counts.value[e];
+	return sum;
+}
+
+const char* PerfCounters::event_name(perf_event_id_t event)
+{
+	switch (event) {
+		case PERF_EV_CYCLES:       return "cycles";
+		case PERF_EV_INSTRUCTIONS: return "instructions";
+		case PERF_EV_L1D_MISSES:   return "l1d_misses";
+		case PERF_EV_LLC_MISSES:   return "llc_misses";
+		case PERF_EV_HITM:         return "hitm";
+		default:                   return "unknown";
+	}
+}
@@ -0,0 +1,78 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Hardware events collected per thread
+enum perf_event_id_t
+{
+	PERF_EV_CYCLES = 0,
+	PERF_EV_INSTRUCTIONS,
+	PERF_EV_L1D_MISSES,    // L1D read misses
+	PERF_EV_LLC_MISSES,    // last level cache read misses
+	PERF_EV_HITM,          // loads served by a modified line in another core (raw event)
+	PERF_NUM_EVENTS
+};
+
+struct perf_counts_t
+{
+	double value[PERF_NUM_EVENTS];
+};
+
+// Raw config of the HITM event for this CPU, or 0 if there is no known
+// default. Intel: MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM (XSNP_FWD on newer
+// cores), event 0xD2 umask 0x04.
+uint64_t default_hitm_config();
+
+// Per-thread hardware counters through perf_event_open(2). Every thread
+// opens its own event group on itself, then brackets the measured code
+// with start()/stop(); counts accumulate until reset(). Counts are scaled
+// by time_enabled/time_running when the kernel multiplexes the PMU.
+class PerfCounters
+{
+public:
+	PerfCounters(int num_threads, uint64_t hitm_config);
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	// Open the event group of work_id on the calling thread. Returns false
+	// if not even one event could be opened (see error()).
+	bool open_on_current_thread(int work_id);
+
+	void start(int work_id);
+	void stop(int work_id);
+	void reset();
+
+	// True if the event was opened on every thread
+	bool available(perf_event_id_t event) const;
+	bool any_available() const;
+	const std::string& error() const { return error_; }
+
+	int num_threads() const { return static_cast<int>(threads_.size()); }
+	const perf_counts_t& thread_counts(int work_id) const { return threads_[work_id].counts; }
+	perf_counts_t total() const;
+
+	static const char* event_name(perf_event_id_t event);
+
+private:
+	struct alignas(64) thread_state_t
+	{
+		int           fd[PERF_NUM_EVENTS];   // -1 if the event is unavailable
+		int           leader;                // group leader fd
+		int           slot[PERF_NUM_EVENTS]; // position in the group read
+		int           num_open;
+		perf_counts_t counts;
+	};
+
+	uint64_t                    hitm_config_;
+	std::vector<thread_state_t> threads_;
+	std::string                 error_;        // first open failure
+	std::mutex                  error_mutex_;  // threads open their groups concurrently
+};
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,247 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <sched.h>
+#include <x86intrin.h>
+#include "thread_utils.h"
+#include "thread_pool.h"
+#include "numa_placement.h"
+#include "measurement.h"
+#include "result_store.h"
+#include "benchmark_common.h"
+
+#define DEFAULT_ROUNDS 10000       // Round trips per run
+#define DEFAULT_BUDGET 0.2         // Seconds per pair and variant; --budget= overrides
+#define SPIN_LIMIT (1 << 16)       // Spins before yielding on separate CPUs
+#define RESULTS_PATH "../data/pingpong_results.csv"
+
+// How the line is handed from one thread to the other
+enum handoff_t {
+    HANDOFF_STORE_LOAD,   // spin on loads until the other side's store arrives, then store
+    HANDOFF_RMW           // spin on compare-exchange, every attempt an atomic RMW of the line
+};
+
+const char* handoff_name(handoff_t handoff) {
+    return handoff == HANDOFF_RMW ? "rmw" : "store_load";
+}
+
+// Where two CPUs are relative to each other
+const char* pair_relation(const cpu_topology_t& a, const cpu_topology_t& b) {
+    if (a.cpu == b.cpu) return "same_cpu";
+    if (a.package != b.package) return "cross_package";
+    if (a.core == b.core) return "smt";
+    return "same_package";
+}
+
+// Wait until the flag holds value, yielding the CPU every spin_limit
+// spins. Dedicated cores never get there; two threads on one CPU pass
+// spin_limit = 1, since the other side cannot move before it is scheduled.
+inline void wait_for(std::atomic<uint32_t>& flag, uint32_t value, int spin_limit) {
+    int spins = 0;
+    while (flag.load(std::memory_order_acquire) != value) {
+        __builtin_ia32_pause();
+        if (++spins == spin_limit) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+// Move the flag from value to value + 1 with compare-exchange
+inline void cas_from(std::atomic<uint32_t>& flag, uint32_t value, int spin_limit) {
+    int spins = 0;
+    uint32_t expected = value;
+    while (!flag.compare_exchange_weak(expected, value + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        expected = value;
+        __builtin_ia32_pause();
+        if (++spins == spin_limit) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+// One run: rounds round trips of the line between work_id 0 (odd values)
+// and work_id 1 (even values). Thread 0 times the run in seconds and TSC ticks.
+void ping_pong(handoff_t handoff, ParallelExecutor& exec, std::atomic<uint32_t>& flag, long long rounds,
+               int spin_limit, double* seconds, uint64_t* ticks) {
+    flag.store(0);
+    exec.run([&](int work_id, int) {
+        uint32_t mine = work_id == 0 ? 0 : 1;   // value this thread moves on from
+        auto start = std::chrono::steady_clock::now();
+        uint64_t tsc_start = __rdtsc();
+        for (long long i = 0; i < rounds; ++i, mine += 2) {
+            if (handoff == HANDOFF_RMW) {
+                cas_from(flag, mine, spin_limit);
+            } else {
+                wait_for(flag, mine, spin_limit);
+                flag.store(mine + 1, std::memory_order_release);
+            }
+        }
+        if (work_id == 0) {
+            wait_for(flag, mine, spin_limit);   // last return of the line
+            *ticks = __rdtsc() - tsc_start;
+            *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    });
+}
+
+// NxN matrix of one-way latencies, "-" on the diagonal
+void print_matrix(const char* label, const std::vector<int>& cpus, const std::vector<std::vector<double>>& values) {
+    std::cout << label << "\n" << std::setw(6) << "cpu";
+    for (int cpu : cpus) std::cout << std::setw(10) << cpu;
+    std::cout << "\n" << std::fixed << std::setprecision(1);
+    for (std::size_t i = 0; i < cpus.size(); ++i) {
+        std::cout << std::setw(6) << cpus[i];
+        for (std::size_t j = 0; j < cpus.size(); ++j) {
+            if (i == j) std::cout << std::setw(10) << "-";
+            else std::cout << std::setw(10) << values[i][j];
+        }
+        std::cout << "\n";
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+int main(int argc, char** argv) {
+    begin_run(argc, argv);
+    std::vector<int> cpus;
+    std::vector<handoff_t> handoffs = { HANDOFF_STORE_LOAD, HANDOFF_RMW };
+    long long rounds = DEFAULT_ROUNDS;
+    measure_config_t config = default_measure_config();
+    config.time_budget = DEFAULT_BUDGET;
+    for (int i = 1; i < argc; ++i) {
+        if (parse_measure_option(argv[i], &config)) continue;
+        if (std::strncmp(argv[i], "--rounds=", 9) == 0) {
+            rounds = std::atoll(argv[i] + 9);
+            if (rounds <= 0) {
+                std::cerr << "Invalid round count '" << (argv[i] + 9) << "' (must be > 0)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--cpus=", 7) == 0) {
+            for (const std::string& text : split_list(argv[i] + 7)) {
+                char* end = nullptr;
+                long cpu = std::strtol(text.c_str(), &end, 10);
+                if (*end != '\0' || cpu < 0 || cpu >= CPU_SETSIZE) {
+                    std::cerr << "Invalid CPU '" << text << "'\n";
+                    return 1;
+                }
+                cpus.push_back(static_cast<int>(cpu));
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--variants=", 11) == 0) {
+            handoffs.clear();
+            for (const std::string& name : split_list(argv[i] + 11)) {
+                if (name != "store_load" && name != "rmw") {
+                    std::cerr << "Unknown variant '" << name << "' (use store_load or rmw)\n";
+                    return 1;
+                }
+                handoffs.push_back(name == "rmw" ? HANDOFF_RMW : HANDOFF_STORE_LOAD);
+            }
+            continue;
+        }
+        std::cerr << "Unknown option '" << argv[i] << "'\n";
+        return 1;
+    }
+    if (cpus.empty()) cpus = available_cpus();
+    if (cpus.size() < 2) {
+        std::cerr << "Need at least two CPUs to bounce a line between, have " << cpus.size()
+                  << " (--cpus=0,0 runs both threads on CPU 0)\n";
+        return 1;
+    }
+
+    // Topology of the selected CPUs; unknown CPUs count as their own core
+    std::map<int, cpu_topology_t> topology;
+    for (const cpu_topology_t& t : query_cpu_topology()) topology[t.cpu] = t;
+    for (int cpu : cpus)
+        if (!topology.count(cpu)) topology[cpu] = { cpu, 0, cpu, 0 };
+
+    std::ofstream csv;
+    if (!open_csv(csv, RESULTS_PATH,
+                  "variant,cpu_a,cpu_b,package_a,package_b,relation,rounds,latency_ns,latency_cycles,min_ns,p90_ns,cv,runs")) {
+        std::cerr << "Cannot write results '" << RESULTS_PATH << "'\n";
+        return 1;
+    }
+
+    double ticks_per_ns = tsc_ticks_per_ns();
+    std::cout << "🏓 Core-to-Core Ping-Pong Benchmark\n";
+    std::cout << "🔄 " << rounds << " round trips per run, " << cpus.size() << " CPUs, TSC "
+              << ticks_per_ns << " GHz\n";
+
+    // The flag line alone; nothing else shares it
+    Padded<std::atomic<uint32_t>> flag;
+    for (handoff_t handoff : handoffs) {
+        std::vector<std::vector<double>> ns(cpus.size(), std::vector<double>(cpus.size(), 0.0));
+        std::vector<std::vector<double>> cycles = ns;
+        std::map<std::string, std::vector<double>> by_relation;
+        std::cout << "\n🔁 " << handoff_name(handoff) << "\n";
+
+        // A round trip costs the same in both directions, so every pair is
+        // measured once and mirrored
+        for (std::size_t i = 0; i < cpus.size(); ++i) {
+            for (std::size_t j = i + 1; j < cpus.size(); ++j) {
+                ParallelExecutor exec(BACKEND_POOL, 2, { cpus[i], cpus[j] });
+                const int spin_limit = cpus[i] == cpus[j] ? 1 : SPIN_LIMIT;
+                std::vector<double> run_ticks;
+                measure_stats_t time = measure(config, [&](int run) {
+                    double seconds = 0.0;
+                    uint64_t ticks = 0;
+                    ping_pong(handoff, exec, flag.value, rounds, spin_limit, &seconds, &ticks);
+                    if (run >= 0) run_ticks.push_back(static_cast<double>(ticks));
+                    return seconds;
+                });
+                measure_stats_t tsc = summarize_samples(run_ticks);
+
+                // One-way latency: half a round trip
+                const double handoffs_per_run = 2.0 * rounds;
+                ns[i][j] = ns[j][i] = time.median / handoffs_per_run * 1e9;
+                cycles[i][j] = cycles[j][i] = tsc.median / handoffs_per_run;
+                const cpu_topology_t& a = topology[cpus[i]];
+                const cpu_topology_t& b = topology[cpus[j]];
+                const char* relation = pair_relation(a, b);
+                by_relation[relation].push_back(ns[i][j]);
+
+                csv << handoff_name(handoff) << "," << cpus[i] << "," << cpus[j] << "," << a.package << ","
+                    << b.package << "," << relation << "," << rounds << "," << ns[i][j] << "," << cycles[i][j] << ","
+                    << time.min / handoffs_per_run * 1e9 << "," << time.p90 / handoffs_per_run * 1e9 << ","
+                    << time.cv << "," << time.runs << "\n";
+
+                JsonRecord record;
+                record.add("benchmark", "pingpong")
+                      .add("variant", handoff_name(handoff))
+                      .add("cpu_a", cpus[i])
+                      .add("cpu_b", cpus[j])
+                      .add("relation", relation)
+                      .add("rounds", rounds);
+
+                JsonRecord result;
+                result.add("time", time)
+                      .add("latency_ns", ns[i][j])
+                      .add("latency_cycles", cycles[i][j]);
+                store_result(MEASUREMENTS_PATH, record, result);
+            }
+        }
+
+        print_matrix("⏱️  One-way latency (ns)", cpus, ns);
+        print_matrix("⏱️  One-way latency (TSC cycles)", cpus, cycles);
+        for (const auto& entry : by_relation) {
+            double sum = 0.0;
+            for (double v : entry.second) sum += v;
+            std::cout << "📊 " << entry.first << ": " << sum / entry.second.size() << " ns mean over "
+                      << entry.second.size() << " pairs\n";
+        }
+    }
+    return 0;
+}
+// g++ -fopenmp -O3 -march=native -std=c++17 -o pingpong_benchmark pingpong_benchmark.cpp benchmark_common.cpp thread_utils.cpp thread_pool.cpp numa_placement.cpp perf_counters.cpp write_tracker.cpp timeline.cpp measurement.cpp result_store.cpp cache_info.cpp
+// ./pingpong_benchmark [--cpus=0,1,8,9] [--variants=store_load,rmw] [--rounds=10000] [--budget=0.2]
@@ -0,0 +1,430 @@
+#include "result_store.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include "cache_info.h"
+#include "numa_placement.h"
+
+static std::unique_ptr<run_metadata_t> current;
+
+// "48K", "2M": sizes as sysfs prints them
+static std::string size_text(std::size_t bytes)
+{
+	if (bytes % (1024 * 1024) == 0) return std::to_string(bytes / (1024 * 1024)) + "M";
+	if (bytes % 1024 == 0) return std::to_string(bytes / 1024) + "K";
+	return std::to_string(bytes);
+}
+
+// Value of the first "key : value" line of a /proc file
+static std::string proc_field(const char* path, const char* key)
+{
+	std::ifstream in(path);
+	std::string line;
+	const std::size_t len = std::strlen(key);
+	while (std::getline(in, line)) {
+		if (line.compare(0, len, key) != 0) continue;
+		std::size_t colon = line.find(':');
+		if (colon == std::string::npos) continue;
+		std::size_t start = line.find_first_not_of(" \t", colon + 1);
+		return start == std::string::npos ? std::string() : line.substr(start);
+	}
+	return std::string();
+}
+
+// First line of a shell command's output, empty on failure
+static std::string command_output(const char* command)
+{
+	FILE* pipe = popen(command, "r");
+	if (!pipe) return std::string();
+	char buf[256];
+	std::string out;
+	if (std::fgets(buf, sizeof(buf), pipe)) out = buf;
+	int status = pclose(pipe);
+	if (status != 0) return std::string();
+	while (!out.empty() && std::isspace(static_cast<unsigned char>(out.back()))) out.pop_back();
+	return out;
+}
+
+// FNV-1a, 64 bits
+static uint64_t fnv1a(const std::string& text)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (unsigned char c : text) {
+		hash ^= c;
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+// The flags the build passed in BUILD_FLAGS, or the ones the predefined
+// macros of this translation unit reveal
+static std::string build_flags()
+{
+#ifdef BUILD_FLAGS
+	return BUILD_FLAGS;
+#else
+	std::string flags;
+#ifdef __OPTIMIZE__
+	flags += "-O";
+#else
+	flags += "-O0";
+#endif
+#ifdef _OPENMP
+	flags += " -fopenmp";
+#endif
+#if defined(__AVX512F__)
+	flags += " avx512f";
+#elif defined(__AVX2__)
+	flags += " avx2";
+#elif defined(__SSE2__)
+	flags += " sse2";
+#endif
+#ifdef __FMA__
+	flags += " fma";
+#endif
+#ifdef WRITE_TRACKING
+	flags += " -DWRITE_TRACKING";
+#endif
+	return flags;
+#endif
+}
+
+static std::string git_revision()
+{
+#ifdef GIT_REVISION
+	return GIT_REVISION;
+#else
+	std::string revision = command_output("git describe --always --dirty --abbrev=12 2>/dev/null");
+	return revision.empty() ? "unknown" : revision;
+#endif
+}
+
+static run_metadata_t collect_run_metadata(int argc, char** argv)
+{
+	run_metadata_t run;
+
+	std::time_t now = std::time(nullptr);
+	std::tm utc;
+	gmtime_r(&now, &utc);
+	char buf[64];
+	std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &utc);
+	run.timestamp = buf;
+	std::strftime(buf, sizeof(buf), "%Y%m%dT%H%M%SZ", &utc);
+	run.id = std::string(buf) + "-" + std::to_string(getpid());
+
+	if (argc > 0) {
+		std::string path = argv[0];
+		std::size_t slash = path.rfind('/');
+		run.program = slash == std::string::npos ? path : path.substr(slash + 1);
+	}
+	for (int i = 0; i < argc; ++i) {
+		if (i) run.command_line += " ";
+		run.command_line += argv[i];
+	}
+
+	char host[256] = "";
+	gethostname(host, sizeof(host) - 1);
+	run.host = host;
+
+	run.cpu_model = proc_field("/proc/cpuinfo", "model name");
+	if (run.cpu_model.empty()) run.cpu_model = "unknown";
+	run.cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+	run.numa_nodes = static_cast<int>(online_numa_nodes().size());
+	cache_info_t cache = query_cache_info();
+	run.caches = "L1d " + size_text(cache.l1d_size) + ", L2 " + size_text(cache.l2_size) + ", L3 " +
+	             size_text(cache.l3_size);
+	run.memory_kb = std::atoll(proc_field("/proc/meminfo", "MemTotal").c_str());
+
+	struct utsname uts;
+	if (uname(&uts) == 0) run.kernel = std::string(uts.sysname) + " " + uts.release;
+
+	// Hardware only: the same machine keeps its fingerprint across kernel
+	// updates, host renames and containers
+	std::ostringstream hardware;
+	hardware << run.cpu_model << "|" << run.cpus << "|" << run.numa_nodes << "|" << run.caches << "|"
+	         << run.memory_kb / (1024 * 1024);
+	std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(fnv1a(hardware.str())));
+	run.fingerprint = buf;
+
+#ifdef __VERSION__
+	run.compiler = __VERSION__;
+#endif
+	run.flags = build_flags();
+	run.git_revision = git_revision();
+	return run;
+}
+
+const run_metadata_t& begin_run(int argc, char** argv)
+{
+	current.reset(new run_metadata_t(collect_run_metadata(argc, argv)));
+	return *current;
+}
+
+const run_metadata_t& current_run()
+{
+	if (!current) current.reset(new run_metadata_t(collect_run_metadata(0, nullptr)));
+	return *current;
+}
+
+JsonRecord run_record(const run_metadata_t& run)
+{
+	JsonRecord record;
+	record.add("id", run.id)
+	      .add("timestamp", run.timestamp)
+	      .add("program", run.program)
+	      .add("command_line", run.command_line)
+	      .add("host", run.host)
+	      .add("fingerprint", run.fingerprint)
+	      .add("cpu_model", run.cpu_model)
+	      .add("cpus", run.cpus)
+	      .add("numa_nodes", run.numa_nodes)
+	      .add("caches", run.caches)
+	      .add("memory_kb", run.memory_kb)
+	      .add("kernel", run.kernel)
+	      .add("compiler", run.compiler)
+	      .add("flags", run.flags)
+	      .add("git_revision", run.git_revision);
+	return record;
+}
+
+void store_result(const char* path, JsonRecord config, const JsonRecord& result)
+{
+	config.add("result", result);
+	config.add("run", run_record(current_run()));
+	append_json_record(path, config);
+}
+
+const json_value_t* json_value_t::find(const char* key) const
+{
+	for (const auto& field : fields)
+		if (field.first == key) return &field.second;
+	return nullptr;
+}
+
+std::string json_value_t::string_field(const char* key, const char* fallback) const
+{
+	const json_value_t* value = find(key);
+	return value && value->kind == STRING ? value->text : std::string(fallback);
+}
+
+// Recursive descent over the subset of JSON that JsonRecord writes
+struct json_parser_t
+{
+	const std::string& s;
+	std::size_t        pos;
+
+	void skip_space()
+	{
+		while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos]))) ++pos;
+	}
+
+	bool literal(const char* word)
+	{
+		std::size_t len = std::strlen(word);
+		if (s.compare(pos, len, word) != 0) return false;
+		pos += len;
+		return true;
+	}
+
+	bool string(std::string* out)
+	{
+		if (pos >= s.size() || s[pos] != '"') return false;
+		++pos;
+		out->clear();
+		while (pos < s.size() && s[pos] != '"') {
+			char c = s[pos++];
+			if (c != '\\') {
+				*out += c;
+				continue;
+			}
+			if (pos >= s.size()) return false;
+			char e = s[pos++];
+			switch (e) {
+				case 'n': *out += '\n'; break;
+				case 't': *out += '\t'; break;
+				case 'r': *out += '\r'; break;
+				case 'b': *out += '\b'; break;
+				case 'f': *out += '\f'; break;
+				case 'u': {
+					// JsonRecord only escapes control characters this way
+					if (pos + 4 > s.size()) return false;
+					*out += static_cast<char>(std::strtol(s.substr(pos, 4).c_str(), nullptr, 16));
+					pos += 4;
+					break;
+				}
+				default: *out += e; break;
+			}
+		}
+		if (pos >= s.size()) return false;
+		++pos;
+		return true;
+	}
+
+	bool value(json_value_t* out)
+	{
+		skip_space();
+		if (pos >= s.size()) return false;
+		char c = s[pos];
+		if (c == '{') return object(out);
+		if (c == '"') {
+			out->kind = json_value_t::STRING;
+			return string(&out->text);
+		}
+		if (literal("true")) {
+			out->kind = json_value_t::BOOL;
+			out->boolean = true;
+			return true;
+		}
+		if (literal("false")) {
+			out->kind = json_value_t::BOOL;
+			out->boolean = false;
+			return true;
+		}
+		if (literal("null")) {
+			out->kind = json_value_t::NUL;
+			return true;
+		}
+		const char* start = s.c_str() + pos;
+		char* end = nullptr;
+		out->number = std::strtod(start, &end);
+		if (end == start) return false;
+		out->kind = json_value_t::NUMBER;
+		out->text.assign(start, static_cast<std::size_t>(end - start));
+		pos += end - start;
+		return true;
+	}
+
+	bool object(json_value_t* out)
+	{
+		out->kind = json_value_t::OBJECT;
+		out->fields.clear();
+		++pos;
+		skip_space();
+		if (pos < s.size() && s[pos] == '}') {
+			++pos;
+			return true;
+		}
+		while (true) {
+			skip_space();
+			std::string key;
+			if (!string(&key)) return false;
+			skip_space();
+			if (pos >= s.size() || s[pos] != ':') return false;
+			++pos;
+			json_value_t field;
+			if (!value(&field)) return false;
+			out->fields.emplace_back(key, std::move(field));
+			skip_space();
+			if (pos >= s.size()) return false;
+			if (s[pos] == '}') {
+				++pos;
+				return true;
+			}
+			if (s[pos] != ',') return false;
+			++pos;
+		}
+	}
+};
+
+bool parse_json_record(const std::string& line, json_value_t* record)
+{
+	json_parser_t parser = { line, 0 };
+	parser.skip_space();
+	if (parser.pos >= line.size() || line[parser.pos] != '{') return false;
+	if (!parser.object(record)) return false;
+	parser.skip_space();
+	return parser.pos == line.size();
+}
+
+bool load_results(const char* path, std::vector<stored_result_t>* results, std::size_t* skipped)
+{
+	std::ifstream in(path);
+	if (!in) return false;
+	*skipped = 0;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+		stored_result_t result;
+		if (!parse_json_record(line, &result.record)) {
+			++*skipped;
+			continue;
+		}
+		if (const json_value_t* run = result.record.find("run")) {
+			result.run_id       = run->string_field("id");
+			result.fingerprint  = run->string_field("fingerprint");
+			result.git_revision = run->string_field("git_revision");
+		}
+		results->push_back(std::move(result));
+	}
+	return true;
+}
+
+std::string result_config_key(const json_value_t& record, const std::vector<std::string>& ignore)
+{
+	std::vector<std::string> pairs;
+	for (const auto& field : record.fields) {
+		const json_value_t& value = field.second;
+		if (field.first == "run") continue;
+		if (std::find(ignore.begin(), ignore.end(), field.first) != ignore.end()) continue;
+		switch (value.kind) {
+			case json_value_t::STRING:
+				pairs.push_back(field.first + "=" + value.text);
+				break;
+			case json_value_t::BOOL:
+				pairs.push_back(field.first + "=" + (value.boolean ? "true" : "false"));
+				break;
+			case json_value_t::NUMBER:
+				pairs.push_back(field.first + "=" + value.text);
+				break;
+			default:
+				break;
+		}
+	}
+	std::sort(pairs.begin(), pairs.end());
+	std::string key;
+	for (const std::string& pair : pairs) {
+		if (!key.empty()) key += ",";
+		key += pair;
+	}
+	return key;
+}
+
+const json_value_t* result_field(const json_value_t& record, const char* key)
+{
+	const json_value_t* result = record.find("result");
+	return result ? result->find(key) : nullptr;
+}
+
+bool stats_from_json(const json_value_t& value, measure_stats_t* stats)
+{
+	if (value.kind != json_value_t::OBJECT) return false;
+	struct { const char* key; double* out; } doubles[] = {
+		{ "mean", &stats->mean }, { "stddev", &stats->stddev }, { "cv", &stats->cv }, { "ci95", &stats->ci95 },
+		{ "min", &stats->min }, { "median", &stats->median }, { "p90", &stats->p90 }, { "p99", &stats->p99 },
+		{ "max", &stats->max }
+	};
+	for (const auto& d : doubles) {
+		const json_value_t* field = value.find(d.key);
+		if (!field || field->kind != json_value_t::NUMBER) return false;
+		*d.out = field->number;
+	}
+	const json_value_t* runs = value.find("runs");
+	const json_value_t* warmup = value.find("warmup_runs");
+	const json_value_t* outliers = value.find("outliers");
+	const json_value_t* converged = value.find("converged");
+	stats->runs        = runs ? static_cast<int>(runs->number) : 0;
+	stats->warmup_runs = warmup ? static_cast<int>(warmup->number) : 0;
+	stats->outliers    = outliers ? static_cast<int>(outliers->number) : 0;
+	stats->converged   = converged && converged->boolean;
+	return true;
+}
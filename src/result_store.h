@@ -0,0 +1,94 @@
+#ifndef RESULT_STORE_H
+#define RESULT_STORE_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include "measurement.h"
+
+// Where, with what and from which source a process measured. Every record
+// written with store_result() carries it as its "run" object, so records
+// can be compared across machines and revisions without the system_info.txt
+// of the run.
+struct run_metadata_t
+{
+	std::string id;            // <UTC timestamp>-<pid>, unique per process
+	std::string timestamp;     // ISO 8601, UTC
+	std::string program;
+	std::string command_line;
+	std::string host;
+	std::string fingerprint;   // hash of the hardware fields below
+	std::string cpu_model;
+	int         cpus;          // online
+	int         numa_nodes;
+	std::string caches;        // "L1d 48K, L2 2M, L3 105M"
+	long long   memory_kb;
+	std::string kernel;        // uname -sr
+	std::string compiler;
+	std::string flags;         // BUILD_FLAGS if the build defines it, else what the macros tell
+	std::string git_revision;  // GIT_REVISION if defined, else git describe --dirty at run time
+};
+
+// Collect the metadata of this process; later store_result() calls use it.
+// Programs call it first thing in main().
+const run_metadata_t& begin_run(int argc, char** argv);
+
+// The metadata of begin_run(), collected without a command line if it
+// was not called
+const run_metadata_t& current_run();
+
+// The run as a nested record
+JsonRecord run_record(const run_metadata_t& run);
+
+// Append config, with result as its "result" object and current_run() as
+// its "run" object, to the JSON Lines store at path. config holds what the
+// program was asked to measure, result what it measured. The store is only
+// ever appended to.
+void store_result(const char* path, JsonRecord config, const JsonRecord& result);
+
+// A parsed JSON value. The records have no arrays, so neither does this.
+struct json_value_t
+{
+	enum kind_t { NUL, BOOL, NUMBER, STRING, OBJECT };
+
+	kind_t                                             kind = NUL;
+	bool                                               boolean = false;
+	double                                             number = 0.0;
+	std::string                                        text;     // STRING, or the literal of a NUMBER
+	std::vector<std::pair<std::string, json_value_t>> fields;   // OBJECT, in file order
+
+	// Field of an object, nullptr if missing
+	const json_value_t* find(const char* key) const;
+	// String field, or fallback if missing or not a string
+	std::string string_field(const char* key, const char* fallback = "") const;
+};
+
+// Parse one JSON object; false on malformed input
+bool parse_json_record(const std::string& line, json_value_t* record);
+
+// One record of a store
+struct stored_result_t
+{
+	std::string  run_id;         // empty for records written before the run object
+	std::string  fingerprint;
+	std::string  git_revision;
+	json_value_t record;
+};
+
+// Read every record of a JSON Lines store. Returns false if the file
+// cannot be opened; lines that do not parse are counted in *skipped.
+bool load_results(const char* path, std::vector<stored_result_t>* results, std::size_t* skipped);
+
+// The configuration of a record: its top-level scalars other than those in
+// ignore, as "key=value" pairs sorted by key. The measured values are in
+// the nested "result" object and the process in "run", so neither counts.
+std::string result_config_key(const json_value_t& record, const std::vector<std::string>& ignore);
+
+// A measured field of a record, from its "result" object; nullptr if absent
+const json_value_t* result_field(const json_value_t& record, const char* key);
+
+// Read a stats object written by JsonRecord::add(key, measure_stats_t)
+bool stats_from_json(const json_value_t& value, measure_stats_t* stats);
+
+#endif // RESULT_STORE_H
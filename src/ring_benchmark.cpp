@@ -0,0 +1,363 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <string>
+#include <sched.h>
+#include <x86intrin.h>
+#include "ring_buffer.h"
+#include "thread_utils.h"
+#include "thread_pool.h"
+#include "numa_placement.h"
+#include "measurement.h"
+#include "result_store.h"
+#include "benchmark_common.h"
+
+#define DEFAULT_MESSAGES (1 << 20)   // Messages per run, over all producers
+#define DEFAULT_CAPACITY 1024        // Slots per ring
+#define DEFAULT_BUDGET 0.5           // Seconds per cell; --budget= overrides
+#define SPIN_LIMIT (1 << 10)         // Failed attempts before yielding on dedicated CPUs
+#define RESULTS_PATH "../data/ring_results.csv"
+
+enum queue_kind_t {
+    QUEUE_SPSC,
+    QUEUE_MPMC
+};
+
+const char* queue_name(queue_kind_t queue) {
+    return queue == QUEUE_MPMC ? "mpmc" : "spsc";
+}
+
+// Layouts each ring implements
+bool layout_supported(queue_kind_t queue, ring_layout_t layout) {
+    return queue == QUEUE_SPSC ? layout != RING_SLOTS : layout != RING_CACHED;
+}
+
+// Timing of one cell plus the per-message latencies of its last measured run
+struct ring_result_t {
+    measure_stats_t time;
+    std::vector<uint64_t> latency_ticks;   // sorted
+};
+
+// Messages of worker i of n
+inline long long share(long long messages, int i, int n) {
+    return messages / n + (i < messages % n ? 1 : 0);
+}
+
+// After a failed push or pop: pause, and give the CPU away every
+// spin_limit attempts. Threads sharing a CPU pass spin_limit = 1, since
+// the other side cannot move before it is scheduled.
+inline void backoff(int& spins, int spin_limit) {
+    __builtin_ia32_pause();
+    if (++spins >= spin_limit) {
+        sched_yield();
+        spins = 0;
+    }
+}
+
+// Push 1..messages through the ring and check that the consumers see each
+// value once, by count and sum. Run once per cell before it is timed.
+template <typename Ring>
+bool verify_ring(Ring& ring, ParallelExecutor& exec, int producers, int consumers, long long messages, int spin_limit) {
+    PerThread<uint64_t> sums(consumers);
+    exec.run([&](int work_id, int) {
+        int spins = 0;
+        if (work_id < producers) {
+            // Producer p sends p + 1, p + 1 + producers, ...
+            long long count = share(messages, work_id, producers);
+            for (long long i = 0; i < count; ++i) {
+                const uint64_t value = static_cast<uint64_t>(work_id + 1 + i * producers);
+                while (!ring.try_push(value)) backoff(spins, spin_limit);
+            }
+        } else {
+            const int c = work_id - producers;
+            long long count = share(messages, c, consumers);
+            uint64_t sum = 0;
+            for (long long i = 0; i < count; ++i) {
+                uint64_t value = 0;
+                while (!ring.try_pop(&value)) backoff(spins, spin_limit);
+                sum += value;
+            }
+            sums[c] = sum;
+        }
+    });
+    const uint64_t n = static_cast<uint64_t>(messages);
+    return sums.combine(0, [](uint64_t a, uint64_t b) { return a + b; }) == n * (n + 1) / 2;
+}
+
+// Every message is the TSC at the producer's first push attempt; the
+// consumer stores now - stamp, so the latency includes waiting for a free
+// slot and for a consumer. Throughput is over the wall time of the run.
+template <typename Ring>
+bool run_ring(ParallelExecutor& exec, int producers, int consumers, long long messages, std::size_t capacity,
+              int spin_limit, const measure_config_t& config, ring_result_t* result) {
+    Ring ring(capacity);
+    if (!verify_ring(ring, exec, producers, consumers, messages, spin_limit)) return false;
+
+    std::vector<std::vector<uint64_t>> latencies(consumers);
+    for (int c = 0; c < consumers; ++c) latencies[c].resize(share(messages, c, consumers));
+    result->time = measure(config, [&](int) {
+        auto start_time = std::chrono::steady_clock::now();
+        exec.run([&](int work_id, int) {
+            if (work_id < producers) {
+                long long count = share(messages, work_id, producers);
+                for (long long i = 0; i < count; ++i) {
+                    int spins = 0;
+                    const uint64_t stamp = __rdtsc();
+                    while (!ring.try_push(stamp)) backoff(spins, spin_limit);
+                }
+            } else {
+                uint64_t* lat = latencies[work_id - producers].data();
+                long long count = share(messages, work_id - producers, consumers);
+                for (long long i = 0; i < count; ++i) {
+                    int spins = 0;
+                    uint64_t stamp = 0;
+                    while (!ring.try_pop(&stamp)) backoff(spins, spin_limit);
+                    lat[i] = __rdtsc() - stamp;
+                }
+            }
+        });
+        auto end_time = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end_time - start_time).count();
+    });
+
+    result->latency_ticks.clear();
+    for (const std::vector<uint64_t>& lat : latencies)
+        result->latency_ticks.insert(result->latency_ticks.end(), lat.begin(), lat.end());
+    std::sort(result->latency_ticks.begin(), result->latency_ticks.end());
+    return true;
+}
+
+bool run_layout(queue_kind_t queue, ring_layout_t layout, ParallelExecutor& exec, int producers, int consumers,
+                long long messages, std::size_t capacity, int spin_limit, const measure_config_t& config,
+                ring_result_t* result) {
+    if (queue == QUEUE_SPSC) {
+        switch (layout) {
+            case RING_PADDED: return run_ring<SpscRing<uint64_t, RING_PADDED>>(exec, 1, 1, messages, capacity, spin_limit, config, result);
+            case RING_CACHED: return run_ring<SpscRing<uint64_t, RING_CACHED>>(exec, 1, 1, messages, capacity, spin_limit, config, result);
+            default:          return run_ring<SpscRing<uint64_t, RING_PACKED>>(exec, 1, 1, messages, capacity, spin_limit, config, result);
+        }
+    }
+    switch (layout) {
+        case RING_PADDED: return run_ring<MpmcRing<uint64_t, RING_PADDED>>(exec, producers, consumers, messages, capacity, spin_limit, config, result);
+        case RING_SLOTS:  return run_ring<MpmcRing<uint64_t, RING_SLOTS>>(exec, producers, consumers, messages, capacity, spin_limit, config, result);
+        default:          return run_ring<MpmcRing<uint64_t, RING_PACKED>>(exec, producers, consumers, messages, capacity, spin_limit, config, result);
+    }
+}
+
+// q-quantile of sorted ticks, in ns
+double latency_ns(const std::vector<uint64_t>& sorted, double q, double ticks_per_ns) {
+    if (sorted.empty()) return 0.0;
+    std::size_t index = static_cast<std::size_t>(q * (sorted.size() - 1));
+    return sorted[index] / ticks_per_ns;
+}
+
+std::string cpu_list(const std::vector<int>& cpus) {
+    if (cpus.empty()) return "any";
+    std::string text;
+    for (int cpu : cpus) text += (text.empty() ? "" : ";") + std::to_string(cpu);
+    return text;
+}
+
+int main(int argc, char** argv) {
+    begin_run(argc, argv);
+    std::vector<queue_kind_t> queues = { QUEUE_SPSC, QUEUE_MPMC };
+    std::vector<ring_layout_t> layouts = { RING_PACKED, RING_PADDED, RING_CACHED, RING_SLOTS };
+    std::vector<pin_policy_t> pins = { PIN_NONE, PIN_COMPACT, PIN_SCATTER, PIN_SMT };
+    std::vector<int> explicit_cpus;
+    int producers = 2, consumers = 2;
+    std::size_t messages = DEFAULT_MESSAGES;
+    std::size_t capacity = DEFAULT_CAPACITY;
+    measure_config_t config = default_measure_config();
+    config.time_budget = DEFAULT_BUDGET;
+    for (int i = 1; i < argc; ++i) {
+        if (parse_measure_option(argv[i], &config)) continue;
+        if (std::strncmp(argv[i], "--queues=", 9) == 0) {
+            queues.clear();
+            for (const std::string& name : split_list(argv[i] + 9)) {
+                if (name != "spsc" && name != "mpmc") {
+                    std::cerr << "Unknown queue '" << name << "' (use spsc or mpmc)\n";
+                    return 1;
+                }
+                queues.push_back(name == "mpmc" ? QUEUE_MPMC : QUEUE_SPSC);
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--layouts=", 10) == 0) {
+            layouts.clear();
+            for (const std::string& name : split_list(argv[i] + 10)) {
+                ring_layout_t layout;
+                if (!parse_ring_layout(name.c_str(), &layout)) {
+                    std::cerr << "Unknown layout '" << name << "' (use packed, padded, cached or slots)\n";
+                    return 1;
+                }
+                layouts.push_back(layout);
+            }
+            // Packed first: the other layouts are compared with it
+            std::sort(layouts.begin(), layouts.end());
+            continue;
+        }
+        if (std::strncmp(argv[i], "--pin=", 6) == 0) {
+            pins.clear();
+            for (const std::string& name : split_list(argv[i] + 6)) {
+                pin_policy_t pin;
+                if (!parse_pin_policy(name.c_str(), &pin)) {
+                    std::cerr << "Unknown pin policy '" << name << "' (use none, compact, scatter or smt)\n";
+                    return 1;
+                }
+                pins.push_back(pin);
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--cpus=", 7) == 0) {
+            for (const std::string& text : split_list(argv[i] + 7)) {
+                char* end = nullptr;
+                long cpu = std::strtol(text.c_str(), &end, 10);
+                if (*end != '\0' || cpu < 0 || cpu >= CPU_SETSIZE) {
+                    std::cerr << "Invalid CPU '" << text << "'\n";
+                    return 1;
+                }
+                explicit_cpus.push_back(static_cast<int>(cpu));
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--producers=", 12) == 0 || std::strncmp(argv[i], "--consumers=", 12) == 0) {
+            int value = std::atoi(argv[i] + 12);
+            if (value < 1) {
+                std::cerr << "Invalid thread count in '" << argv[i] << "' (must be > 0)\n";
+                return 1;
+            }
+            (argv[i][2] == 'p' ? producers : consumers) = value;
+            continue;
+        }
+        if (std::strncmp(argv[i], "--messages=", 11) == 0) {
+            if (!parse_count(argv[i] + 11, &messages)) {
+                std::cerr << "Invalid message count '" << (argv[i] + 11) << "'\n";
+                return 1;
+            }
+            continue;
+        }
+        if (std::strncmp(argv[i], "--capacity=", 11) == 0) {
+            if (!parse_count(argv[i] + 11, &capacity)) {
+                std::cerr << "Invalid capacity '" << (argv[i] + 11) << "'\n";
+                return 1;
+            }
+            continue;
+        }
+        std::cerr << "Unknown option '" << argv[i] << "'\n";
+        return 1;
+    }
+
+    std::ofstream csv;
+    if (!open_csv(csv, RESULTS_PATH,
+                  "queue,layout,producers,consumers,pin,cpus,capacity,messages,time,min,p90,cv,runs,msgs_per_sec,"
+                  "vs_packed,vs_packed_significant,lat_p50_ns,lat_p90_ns,lat_p99_ns,lat_p999_ns,lat_max_ns")) {
+        std::cerr << "Cannot write results '" << RESULTS_PATH << "'\n";
+        return 1;
+    }
+
+    const double ticks_per_ns = tsc_ticks_per_ns();
+    const std::size_t available = available_cpus().size();
+    std::cout << "📨 Ring Buffer Benchmark\n";
+    std::cout << "🔄 " << messages << " messages per run, " << ring_capacity(capacity) << " slots, MPMC "
+              << producers << " producers / " << consumers << " consumers, TSC " << ticks_per_ns << " GHz\n";
+
+    for (queue_kind_t queue : queues) {
+        const int p = queue == QUEUE_MPMC ? producers : 1;
+        const int c = queue == QUEUE_MPMC ? consumers : 1;
+        const int threads = p + c;
+
+        // Placements, skipping those that land on CPUs already measured
+        std::vector<std::pair<std::string, std::vector<int>>> placements;
+        if (!explicit_cpus.empty()) {
+            std::vector<int> cpus;
+            for (int t = 0; t < threads; ++t) cpus.push_back(explicit_cpus[t % explicit_cpus.size()]);
+            placements.push_back({ "cpus", cpus });
+        }
+        for (pin_policy_t pin : explicit_cpus.empty() ? pins : std::vector<pin_policy_t>()) {
+            std::vector<int> cpus = pin_policy_cpus(pin, threads);
+            bool seen = false;
+            for (const auto& placement : placements) seen = seen || (!cpus.empty() && placement.second == cpus);
+            if (seen) {
+                std::cout << "⏭️  " << queue_name(queue) << " " << pin_policy_name(pin) << ": same CPUs as an earlier placement\n";
+                continue;
+            }
+            placements.push_back({ pin_policy_name(pin), cpus });
+        }
+
+        for (const auto& placement : placements) {
+            const std::vector<int>& cpus = placement.second;
+            std::set<int> distinct(cpus.begin(), cpus.end());
+            const bool shared_cpus = cpus.empty() ? static_cast<std::size_t>(threads) > available
+                                                  : distinct.size() < cpus.size();
+            const int spin_limit = shared_cpus ? 1 : SPIN_LIMIT;
+            ParallelExecutor exec(BACKEND_POOL, threads, cpus);
+            std::cout << "\n🧵 " << queue_name(queue) << ", " << p << "P/" << c << "C, " << placement.first
+                      << " (CPUs " << cpu_list(cpus) << ")" << (shared_cpus ? ", threads share CPUs" : "") << "\n";
+
+            measure_stats_t packed = {};
+            for (ring_layout_t layout : layouts) {
+                if (!layout_supported(queue, layout)) continue;
+                ring_result_t result;
+                if (!run_layout(queue, layout, exec, p, c, static_cast<long long>(messages), capacity, spin_limit,
+                                config, &result)) {
+                    std::cerr << "❌ " << queue_name(queue) << " " << ring_layout_name(layout)
+                              << ": consumers did not receive every message exactly once\n";
+                    return 1;
+                }
+                const measure_stats_t& time = result.time;
+                if (layout == RING_PACKED) packed = time;
+                const bool have_packed = packed.runs > 0;
+                const double vs_packed = have_packed ? packed.median / time.median : 0.0;
+                const bool significant = have_packed && stats_differ(packed, time);
+                const double msgs_per_sec = messages / time.median;
+                const std::vector<uint64_t>& lat = result.latency_ticks;
+                const double p50 = latency_ns(lat, 0.5, ticks_per_ns), p90 = latency_ns(lat, 0.9, ticks_per_ns);
+                const double p99 = latency_ns(lat, 0.99, ticks_per_ns), p999 = latency_ns(lat, 0.999, ticks_per_ns);
+                const double max = latency_ns(lat, 1.0, ticks_per_ns);
+
+                std::cout << "  " << ring_layout_name(layout) << ": " << msgs_per_sec / 1e6 << " M msg/s (CV "
+                          << time.cv * 100.0 << "%, " << time.runs << " runs)";
+                if (layout != RING_PACKED && have_packed)
+                    std::cout << ", " << vs_packed << "x packed" << (significant ? "" : " (within noise)");
+                std::cout << ", latency p50 " << p50 << " ns, p99 " << p99 << " ns, p99.9 " << p999 << " ns\n";
+
+                csv << queue_name(queue) << "," << ring_layout_name(layout) << "," << p << "," << c << ","
+                    << placement.first << "," << cpu_list(cpus) << "," << ring_capacity(capacity) << "," << messages << ","
+                    << time.median << "," << time.min << "," << time.p90 << "," << time.cv << "," << time.runs << ","
+                    << msgs_per_sec << ",";
+                if (have_packed) csv << vs_packed << "," << significant;
+                else csv << ",";
+                csv << "," << p50 << "," << p90 << "," << p99 << "," << p999 << "," << max << "\n";
+
+                JsonRecord record;
+                record.add("benchmark", "ring")
+                      .add("queue", queue_name(queue))
+                      .add("layout", ring_layout_name(layout))
+                      .add("producers", p)
+                      .add("consumers", c)
+                      .add("pin", placement.first)
+                      .add("cpus", cpu_list(cpus))
+                      .add("capacity", ring_capacity(capacity))
+                      .add("messages", messages);
+
+                JsonRecord measured;
+                measured.add("time", time)
+                        .add("msgs_per_sec", msgs_per_sec)
+                        .add("latency_p50_ns", p50)
+                        .add("latency_p99_ns", p99)
+                        .add("latency_p999_ns", p999);
+                store_result(MEASUREMENTS_PATH, record, measured);
+            }
+        }
+    }
+    return 0;
+}
+// g++ -fopenmp -O3 -march=native -std=c++17 -o ring_benchmark ring_benchmark.cpp ring_buffer.cpp benchmark_common.cpp thread_utils.cpp thread_pool.cpp numa_placement.cpp perf_counters.cpp write_tracker.cpp timeline.cpp measurement.cpp result_store.cpp cache_info.cpp
+// ./ring_benchmark [--queues=spsc,mpmc] [--layouts=packed,padded,cached,slots] [--pin=none,compact,scatter,smt] [--cpus=0,1] [--producers=2] [--consumers=2] [--messages=1M] [--capacity=1024] [--budget=0.5]
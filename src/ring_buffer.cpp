@@ -0,0 +1,24 @@
+#include "ring_buffer.h"
+
+#include <cstring>
+
+bool parse_ring_layout(const char* name, ring_layout_t* layout)
+{
+	for (int i = RING_PACKED; i <= RING_SLOTS; ++i) {
+		if (std::strcmp(name, ring_layout_name(static_cast<ring_layout_t>(i))) == 0) {
+			*layout = static_cast<ring_layout_t>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* ring_layout_name(ring_layout_t layout)
+{
+	switch (layout) {
+		case RING_PADDED: return "padded";
+		case RING_CACHED: return "cached";
+		case RING_SLOTS:  return "slots";
+		default:          return "packed";
+	}
+}
@@ -0,0 +1,189 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "thread_utils.h"
+
+#define RING_LINE_SIZE 64
+
+// Where the indices of a ring sit relative to each other
+enum ring_layout_t
+{
+	RING_PACKED = 0,   // head, tail and the ring's fields share a line
+	RING_PADDED,       // producer index, consumer index and the read-only fields on lines of their own
+	RING_CACHED,       // padded, and each side keeps a private copy of the other's index (SPSC)
+	RING_SLOTS         // padded, and every slot on a line of its own (MPMC)
+};
+
+// Parse "packed", "padded", "cached" or "slots"
+bool parse_ring_layout(const char* name, ring_layout_t* layout);
+const char* ring_layout_name(ring_layout_t layout);
+
+// Smallest power of two >= max(capacity, 2)
+inline std::size_t ring_capacity(std::size_t capacity)
+{
+	std::size_t rounded = 2;
+	while (rounded < capacity) rounded *= 2;
+	return rounded;
+}
+
+// Bounded single-producer single-consumer ring. Indices only grow and are
+// masked on access, so full is tail - head == capacity. Layout RING_PACKED,
+// RING_PADDED or RING_CACHED. With RING_CACHED the producer re-reads head
+// only when the ring looks full with its cached copy, and the consumer
+// re-reads tail only when it looks empty, so in steady state each side
+// touches the other's line once per lap instead of once per message.
+template <typename T, ring_layout_t Layout>
+class alignas(Layout == RING_PACKED ? alignof(std::atomic<std::size_t>) : RING_LINE_SIZE) SpscRing
+{
+	static_assert(Layout != RING_SLOTS, "SpscRing supports RING_PACKED, RING_PADDED and RING_CACHED");
+	static constexpr std::size_t IndexAlign = Layout == RING_PACKED ? alignof(std::atomic<std::size_t>) : RING_LINE_SIZE;
+
+public:
+	explicit SpscRing(std::size_t capacity)
+		: slots_(ring_capacity(capacity)), mask_(slots_.size() - 1),
+		  tail_(0), head_cache_(0), head_(0), tail_cache_(0)
+	{
+	}
+
+	SpscRing(const SpscRing&) = delete;
+	SpscRing& operator=(const SpscRing&) = delete;
+
+	std::size_t capacity() const { return mask_ + 1; }
+
+	// Producer only; false if the ring is full
+	bool try_push(const T& value)
+	{
+		const std::size_t tail = tail_.load(std::memory_order_relaxed);
+		if (Layout == RING_CACHED) {
+			if (tail - head_cache_ > mask_) {
+				head_cache_ = head_.load(std::memory_order_acquire);
+				if (tail - head_cache_ > mask_) return false;
+			}
+		} else if (tail - head_.load(std::memory_order_acquire) > mask_) {
+			return false;
+		}
+		slots_[tail & mask_] = value;
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only; false if the ring is empty
+	bool try_pop(T* value)
+	{
+		const std::size_t head = head_.load(std::memory_order_relaxed);
+		if (Layout == RING_CACHED) {
+			if (head == tail_cache_) {
+				tail_cache_ = tail_.load(std::memory_order_acquire);
+				if (head == tail_cache_) return false;
+			}
+		} else if (head == tail_.load(std::memory_order_acquire)) {
+			return false;
+		}
+		*value = slots_[head & mask_];
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	// Read-only after construction
+	alignas(IndexAlign) std::vector<T> slots_;
+	std::size_t                        mask_;
+
+	// Written by the producer
+	alignas(IndexAlign) std::atomic<std::size_t> tail_;
+	std::size_t                                  head_cache_;   // RING_CACHED only
+
+	// Written by the consumer
+	alignas(IndexAlign) std::atomic<std::size_t> head_;
+	std::size_t                                  tail_cache_;   // RING_CACHED only
+};
+
+// Bounded multi-producer multi-consumer ring (Vyukov): every slot carries a
+// sequence number that says whose turn it is, so producers only contend on
+// tail, consumers on head, and neither reads the other's index. Layout
+// RING_PACKED, RING_PADDED or RING_SLOTS; with RING_SLOTS a producer filling
+// one slot and a consumer draining the next never share a line.
+template <typename T, ring_layout_t Layout>
+class alignas(Layout == RING_PACKED ? alignof(std::atomic<std::size_t>) : RING_LINE_SIZE) MpmcRing
+{
+	static_assert(Layout != RING_CACHED, "MpmcRing supports RING_PACKED, RING_PADDED and RING_SLOTS");
+	static constexpr std::size_t IndexAlign = Layout == RING_PACKED ? alignof(std::atomic<std::size_t>) : RING_LINE_SIZE;
+
+	struct cell_t
+	{
+		std::atomic<std::size_t> sequence;
+		T                        value;
+	};
+	typedef Padded<cell_t, Layout == RING_SLOTS ? RING_LINE_SIZE : alignof(cell_t)> slot_t;
+
+public:
+	explicit MpmcRing(std::size_t capacity)
+		: slots_(ring_capacity(capacity)), mask_(slots_.size() - 1), tail_(0), head_(0)
+	{
+		for (std::size_t i = 0; i < slots_.size(); ++i)
+			slots_[i].value.sequence.store(i, std::memory_order_relaxed);
+	}
+
+	MpmcRing(const MpmcRing&) = delete;
+	MpmcRing& operator=(const MpmcRing&) = delete;
+
+	std::size_t capacity() const { return mask_ + 1; }
+
+	// Any thread; false if the ring is full
+	bool try_push(const T& value)
+	{
+		std::size_t pos = tail_.load(std::memory_order_relaxed);
+		cell_t* cell;
+		while (true) {
+			cell = &slots_[pos & mask_].value;
+			const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+			if (diff == 0) {
+				if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			} else if (diff < 0) {
+				return false;   // the slot still holds the value from a lap ago
+			} else {
+				pos = tail_.load(std::memory_order_relaxed);
+			}
+		}
+		cell->value = value;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Any thread; false if the ring is empty
+	bool try_pop(T* value)
+	{
+		std::size_t pos = head_.load(std::memory_order_relaxed);
+		cell_t* cell;
+		while (true) {
+			cell = &slots_[pos & mask_].value;
+			const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+			if (diff == 0) {
+				if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			} else if (diff < 0) {
+				return false;   // not written yet
+			} else {
+				pos = head_.load(std::memory_order_relaxed);
+			}
+		}
+		*value = cell->value;
+		cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	// Read-only after construction
+	alignas(IndexAlign) std::vector<slot_t> slots_;
+	std::size_t                             mask_;
+
+	alignas(IndexAlign) std::atomic<std::size_t> tail_;   // producers
+	alignas(IndexAlign) std::atomic<std::size_t> head_;   // consumers
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,164 @@
+#include "roofline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <immintrin.h>
+#include "element_types.h"
+#include "thread_utils.h"
+
+#define FMA_CHAINS 12            // independent accumulators: cover FMA latency on two ports, fit 16 registers
+#define FMA_ITERS  (1 << 18)     // iterations of the FMA loop per thread and run
+#define FMA_A      0.999999f
+#define FMA_B      1e-7f
+
+// One loop per instruction set, like the arithmetic kernels: every
+// accumulator is multiplied and added FMA_ITERS times and stays in a
+// register, so nothing but the FMA units (multiply and add for SSE2)
+// limits it. Each stores the sum in *sink so the loop is not optimized
+// away and returns the flops it did.
+__attribute__((optimize("no-tree-vectorize")))
+static double fma_loop_scalar(float seed, float* sink)
+{
+	float acc[FMA_CHAINS];
+	for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = seed + j;
+	for (int it = 0; it < FMA_ITERS; ++it)
+		for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = acc[j] * FMA_A + FMA_B;
+	float sum = 0.0f;
+	for (int j = 0; j < FMA_CHAINS; ++j) sum += acc[j];
+	*sink = sum;
+	return 2.0 * FMA_CHAINS * FMA_ITERS;
+}
+
+__attribute__((target("sse2")))
+static double fma_loop_sse2(float seed, float* sink)
+{
+	__m128 acc[FMA_CHAINS];
+	for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm_set1_ps(seed + j);
+	const __m128 a = _mm_set1_ps(FMA_A);
+	const __m128 b = _mm_set1_ps(FMA_B);
+	for (int it = 0; it < FMA_ITERS; ++it)
+		for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm_add_ps(_mm_mul_ps(acc[j], a), b);
+	__m128 sum = _mm_setzero_ps();
+	for (int j = 0; j < FMA_CHAINS; ++j) sum = _mm_add_ps(sum, acc[j]);
+	*sink = _mm_cvtss_f32(sum);
+	return 2.0 * 4 * FMA_CHAINS * FMA_ITERS;
+}
+
+__attribute__((target("avx2,fma")))
+static double fma_loop_avx2(float seed, float* sink)
+{
+	__m256 acc[FMA_CHAINS];
+	for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm256_set1_ps(seed + j);
+	const __m256 a = _mm256_set1_ps(FMA_A);
+	const __m256 b = _mm256_set1_ps(FMA_B);
+	for (int it = 0; it < FMA_ITERS; ++it)
+		for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm256_fmadd_ps(acc[j], a, b);
+	__m256 sum = _mm256_setzero_ps();
+	for (int j = 0; j < FMA_CHAINS; ++j) sum = _mm256_add_ps(sum, acc[j]);
+	*sink = _mm256_cvtss_f32(sum);
+	return 2.0 * 8 * FMA_CHAINS * FMA_ITERS;
+}
+
+__attribute__((target("avx512f")))
+static double fma_loop_avx512(float seed, float* sink)
+{
+	__m512 acc[FMA_CHAINS];
+	for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm512_set1_ps(seed + j);
+	const __m512 a = _mm512_set1_ps(FMA_A);
+	const __m512 b = _mm512_set1_ps(FMA_B);
+	for (int it = 0; it < FMA_ITERS; ++it)
+		for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm512_fmadd_ps(acc[j], a, b);
+	*sink = _mm512_reduce_add_ps(acc[0]);
+	for (int j = 1; j < FMA_CHAINS; ++j) *sink += _mm512_reduce_add_ps(acc[j]);
+	return 2.0 * 16 * FMA_CHAINS * FMA_ITERS;
+}
+
+static double fma_loop(simd_isa_t isa, float seed, float* sink)
+{
+	switch (isa) {
+		case ISA_AVX512: return fma_loop_avx512(seed, sink);
+		case ISA_AVX2:   return fma_loop_avx2(seed, sink);
+		case ISA_SSE2:   return fma_loop_sse2(seed, sink);
+		default:         return fma_loop_scalar(seed, sink);
+	}
+}
+
+roofline_t measure_roofline(ParallelExecutor& exec, std::size_t array_bytes, const measure_config_t& config,
+                            simd_isa_t isa)
+{
+	roofline_t roof;
+	roof.threads = exec.num_threads();
+	roof.bandwidth_gbps = 0.0;
+	roof.isa = isa;
+
+	const dim_t n = array_bytes / sizeof(double);
+	double* a = allocate_aligned_buffer<double>(n);
+	double* b = allocate_aligned_buffer<double>(n);
+	double* c = allocate_aligned_buffer<double>(n);
+	exec.run([&](int work_id, int n_way) {
+		dim_t start, end;
+		thread_block_partition(n_way, n, 8, work_id, false, &start, &end);
+		std::fill(a + start, a + end, 1.0);
+		std::fill(b + start, b + end, 2.0);
+		std::fill(c + start, c + end, 0.0);
+	});
+
+	const double scalar = 3.0;
+	struct { const char* name; double bytes_per_elem; } kernels[4] = {
+		{ "copy", 16.0 }, { "scale", 16.0 }, { "add", 24.0 }, { "triad", 24.0 }
+	};
+	for (int k = 0; k < 4; ++k) {
+		measure_stats_t time = measure(config, [&](int) {
+			auto start_time = std::chrono::steady_clock::now();
+			exec.run([&](int work_id, int n_way) {
+				dim_t start, end;
+				thread_block_partition(n_way, n, 8, work_id, false, &start, &end);
+				switch (k) {
+					case 0: for (dim_t i = start; i < end; ++i) c[i] = a[i]; break;
+					case 1: for (dim_t i = start; i < end; ++i) b[i] = scalar * c[i]; break;
+					case 2: for (dim_t i = start; i < end; ++i) c[i] = a[i] + b[i]; break;
+					default: for (dim_t i = start; i < end; ++i) a[i] = b[i] + scalar * c[i]; break;
+				}
+			});
+			auto end_time = std::chrono::steady_clock::now();
+			return std::chrono::duration<double>(end_time - start_time).count();
+		});
+		double gbps = kernels[k].bytes_per_elem * n / time.median / 1e9;
+		roof.stream.push_back({ kernels[k].name, gbps, time });
+		roof.bandwidth_gbps = std::max(roof.bandwidth_gbps, gbps);
+	}
+	free_aligned_buffer(a);
+	free_aligned_buffer(b);
+	free_aligned_buffer(c);
+
+	// Peak over the wall time of the run, so threads that share a core
+	// are not counted as running side by side
+	std::vector<float> sink(exec.num_threads());
+	double flops_per_thread = 0.0;
+	measure_stats_t fma = measure(config, [&](int) {
+		auto start_time = std::chrono::steady_clock::now();
+		exec.run([&](int work_id, int) {
+			double flops = fma_loop(isa, static_cast<float>(work_id), &sink[work_id]);
+			if (work_id == 0) flops_per_thread = flops;
+		});
+		auto end_time = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(end_time - start_time).count();
+	});
+	roof.peak_gflops = flops_per_thread * exec.num_threads() / fma.median / 1e9;
+	return roof;
+}
+
+double ridge_intensity(const roofline_t& roof)
+{
+	return roof.peak_gflops / roof.bandwidth_gbps;
+}
+
+double attainable_gflops(const roofline_t& roof, double intensity)
+{
+	return std::min(roof.peak_gflops, intensity * roof.bandwidth_gbps);
+}
+
+const char* roofline_bound(const roofline_t& roof, double intensity)
+{
+	return intensity < ridge_intensity(roof) ? "memory" : "compute";
+}
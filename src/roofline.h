@@ -0,0 +1,47 @@
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+#include <cstddef>
+#include <vector>
+#include "thread_pool.h"
+#include "measurement.h"
+#include "simd_kernels.h"
+
+// One STREAM kernel on double arrays. Bytes count the loads and stores
+// of the kernel, not write-allocate traffic, as STREAM does.
+struct stream_result_t
+{
+	const char*     kernel;   // "copy", "scale", "add" or "triad"
+	double          gbps;     // from the median time
+	measure_stats_t time;
+};
+
+// Roofs of one executor (thread count, backend and pinning)
+struct roofline_t
+{
+	int                          threads;
+	std::vector<stream_result_t> stream;
+	double                       bandwidth_gbps;   // best sustained STREAM kernel
+	double                       peak_gflops;      // float FMA throughput of all threads
+	simd_isa_t                   isa;              // instruction set of the FMA loop
+};
+
+// Run copy, scale, add and triad on three arrays of array_bytes each,
+// split with thread_block_partition() and first touched by the thread
+// that uses them, then a register-only FMA loop on every thread, built
+// for isa so the compute roof matches the kernels of select_arith_kernel(isa).
+// Use arrays of at least four times the last level cache for memory
+// bandwidth.
+roofline_t measure_roofline(ParallelExecutor& exec, std::size_t array_bytes, const measure_config_t& config,
+                            simd_isa_t isa);
+
+// Flops per byte where the bandwidth roof meets the compute roof
+double ridge_intensity(const roofline_t& roof);
+
+// min(peak, intensity * bandwidth), in GFLOP/s
+double attainable_gflops(const roofline_t& roof, double intensity);
+
+// "memory" left of the ridge, "compute" right of it
+const char* roofline_bound(const roofline_t& roof, double intensity);
+
+#endif // ROOFLINE_H
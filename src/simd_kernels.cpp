@@ -0,0 +1,281 @@
+#include "simd_kernels.h"
+
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+// Cody-Waite split of pi/2: DP1 + DP2 + DP3 ~= pi/2, with DP1 and DP2
+// exactly representable in few bits so j * DP1 and j * DP2 are exact
+// for the quadrant counts reached with |x| <= 8192.
+#define TWO_OVER_PI 0.636619772367581343f
+#define DP1 1.5703125f
+#define DP2 4.837512969970703125e-4f
+#define DP3 7.54978995489188216e-8f
+
+// Minimax coefficients on [-pi/4, pi/4] (Cephes sinf/cosf)
+#define S1 -1.6666654611e-1f
+#define S2  8.3321608736e-3f
+#define S3 -1.9515295891e-4f
+#define C1  4.166664568298827e-2f
+#define C2 -1.388731625493765e-3f
+#define C3  2.443315711809948e-5f
+
+// Scalar version of the vector polynomials, used for loop tails
+static inline float arith_poly(float x)
+{
+	float fj = std::nearbyint(x * TWO_OVER_PI);
+	int   j  = static_cast<int>(fj);
+	float r  = ((x - fj * DP1) - fj * DP2) - fj * DP3;
+	float z  = r * r;
+
+	float s = r + r * z * (S1 + z * (S2 + z * S3));
+	float c = 1.0f - 0.5f * z + z * z * (C1 + z * (C2 + z * C3));
+
+	float sin_x = (j & 1) ? c : s;
+	float cos_x = (j & 1) ? s : c;
+	if (j & 2)         sin_x = -sin_x;
+	if ((j + 1) & 2)   cos_x = -cos_x;
+
+	return std::sqrt(x) + sin_x * cos_x;
+}
+
+static void arith_scalar(float* data, dim_t start, dim_t end)
+{
+	for (dim_t i = start; i < end; ++i) {
+		data[i] = std::sqrt(data[i]) + std::sin(data[i]) * std::cos(data[i]);
+	}
+}
+
+__attribute__((target("sse2")))
+static void arith_sse2(float* data, dim_t start, dim_t end)
+{
+	const __m128  two_over_pi = _mm_set1_ps(TWO_OVER_PI);
+	const __m128  dp1  = _mm_set1_ps(DP1);
+	const __m128  dp2  = _mm_set1_ps(DP2);
+	const __m128  dp3  = _mm_set1_ps(DP3);
+	const __m128  one  = _mm_set1_ps(1.0f);
+	const __m128  half = _mm_set1_ps(0.5f);
+	const __m128i i1   = _mm_set1_epi32(1);
+	const __m128i i2   = _mm_set1_epi32(2);
+
+	dim_t i = start;
+	for (; i + 4 <= end; i += 4) {
+		__m128  x  = _mm_loadu_ps(data + i);
+		__m128i j  = _mm_cvtps_epi32(_mm_mul_ps(x, two_over_pi));
+		__m128  fj = _mm_cvtepi32_ps(j);
+		__m128  r  = _mm_sub_ps(x, _mm_mul_ps(fj, dp1));
+		r = _mm_sub_ps(r, _mm_mul_ps(fj, dp2));
+		r = _mm_sub_ps(r, _mm_mul_ps(fj, dp3));
+		__m128  z  = _mm_mul_ps(r, r);
+
+		__m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(S3), z), _mm_set1_ps(S2));
+		s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(S1));
+		s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(s, z), r));
+
+		__m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(C3), z), _mm_set1_ps(C2));
+		c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(C1));
+		c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+		c = _mm_add_ps(_mm_sub_ps(one, _mm_mul_ps(half, z)), c);
+
+		// Odd quadrants swap sin and cos; bit 1 of j (of j+1) flips the sign of sin (cos)
+		__m128 swap  = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, i1), i1));
+		__m128 sin_x = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+		__m128 cos_x = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+		sin_x = _mm_xor_ps(sin_x, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, i2), 30)));
+		cos_x = _mm_xor_ps(cos_x, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j, i1), i2), 30)));
+
+		_mm_storeu_ps(data + i, _mm_add_ps(_mm_sqrt_ps(x), _mm_mul_ps(sin_x, cos_x)));
+	}
+	for (; i < end; ++i) data[i] = arith_poly(data[i]);
+}
+
+__attribute__((target("avx2,fma")))
+static void arith_avx2(float* data, dim_t start, dim_t end)
+{
+	const __m256  two_over_pi = _mm256_set1_ps(TWO_OVER_PI);
+	const __m256  neg_dp1 = _mm256_set1_ps(-DP1);
+	const __m256  neg_dp2 = _mm256_set1_ps(-DP2);
+	const __m256  neg_dp3 = _mm256_set1_ps(-DP3);
+	const __m256  one      = _mm256_set1_ps(1.0f);
+	const __m256  neg_half = _mm256_set1_ps(-0.5f);
+	const __m256i i1 = _mm256_set1_epi32(1);
+	const __m256i i2 = _mm256_set1_epi32(2);
+
+	dim_t i = start;
+	for (; i + 8 <= end; i += 8) {
+		__m256  x  = _mm256_loadu_ps(data + i);
+		__m256i j  = _mm256_cvtps_epi32(_mm256_mul_ps(x, two_over_pi));
+		__m256  fj = _mm256_cvtepi32_ps(j);
+		__m256  r  = _mm256_fmadd_ps(fj, neg_dp1, x);
+		r = _mm256_fmadd_ps(fj, neg_dp2, r);
+		r = _mm256_fmadd_ps(fj, neg_dp3, r);
+		__m256  z  = _mm256_mul_ps(r, r);
+
+		__m256 s = _mm256_fmadd_ps(_mm256_set1_ps(S3), z, _mm256_set1_ps(S2));
+		s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(S1));
+		s = _mm256_fmadd_ps(_mm256_mul_ps(s, z), r, r);
+
+		__m256 c = _mm256_fmadd_ps(_mm256_set1_ps(C3), z, _mm256_set1_ps(C2));
+		c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(C1));
+		c = _mm256_fmadd_ps(_mm256_mul_ps(c, z), z, _mm256_fmadd_ps(neg_half, z, one));
+
+		__m256 swap  = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, i1), i1));
+		__m256 sin_x = _mm256_blendv_ps(s, c, swap);
+		__m256 cos_x = _mm256_blendv_ps(c, s, swap);
+		sin_x = _mm256_xor_ps(sin_x, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, i2), 30)));
+		cos_x = _mm256_xor_ps(cos_x, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(j, i1), i2), 30)));
+
+		_mm256_storeu_ps(data + i, _mm256_fmadd_ps(sin_x, cos_x, _mm256_sqrt_ps(x)));
+	}
+	for (; i < end; ++i) data[i] = arith_poly(data[i]);
+}
+
+__attribute__((target("avx512f")))
+static void arith_avx512(float* data, dim_t start, dim_t end)
+{
+	const __m512  two_over_pi = _mm512_set1_ps(TWO_OVER_PI);
+	const __m512  neg_dp1 = _mm512_set1_ps(-DP1);
+	const __m512  neg_dp2 = _mm512_set1_ps(-DP2);
+	const __m512  neg_dp3 = _mm512_set1_ps(-DP3);
+	const __m512  one      = _mm512_set1_ps(1.0f);
+	const __m512  neg_half = _mm512_set1_ps(-0.5f);
+	const __m512i i1 = _mm512_set1_epi32(1);
+	const __m512i i2 = _mm512_set1_epi32(2);
+	const __m512i sign = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+
+	dim_t i = start;
+	for (; i + 16 <= end; i += 16) {
+		__m512  x  = _mm512_loadu_ps(data + i);
+		__m512i j  = _mm512_cvtps_epi32(_mm512_mul_ps(x, two_over_pi));
+		__m512  fj = _mm512_cvtepi32_ps(j);
+		__m512  r  = _mm512_fmadd_ps(fj, neg_dp1, x);
+		r = _mm512_fmadd_ps(fj, neg_dp2, r);
+		r = _mm512_fmadd_ps(fj, neg_dp3, r);
+		__m512  z  = _mm512_mul_ps(r, r);
+
+		__m512 s = _mm512_fmadd_ps(_mm512_set1_ps(S3), z, _mm512_set1_ps(S2));
+		s = _mm512_fmadd_ps(s, z, _mm512_set1_ps(S1));
+		s = _mm512_fmadd_ps(_mm512_mul_ps(s, z), r, r);
+
+		__m512 c = _mm512_fmadd_ps(_mm512_set1_ps(C3), z, _mm512_set1_ps(C2));
+		c = _mm512_fmadd_ps(c, z, _mm512_set1_ps(C1));
+		c = _mm512_fmadd_ps(_mm512_mul_ps(c, z), z, _mm512_fmadd_ps(neg_half, z, one));
+
+		__mmask16 swap = _mm512_test_epi32_mask(j, i1);
+		__m512 sin_x = _mm512_mask_blend_ps(swap, s, c);
+		__m512 cos_x = _mm512_mask_blend_ps(swap, c, s);
+		// AVX-512F has no float xor; flip the sign bits in the integer domain
+		__m512i sin_i = _mm512_mask_xor_epi32(_mm512_castps_si512(sin_x),
+		                                      _mm512_test_epi32_mask(j, i2),
+		                                      _mm512_castps_si512(sin_x), sign);
+		__m512i cos_i = _mm512_mask_xor_epi32(_mm512_castps_si512(cos_x),
+		                                      _mm512_test_epi32_mask(_mm512_add_epi32(j, i1), i2),
+		                                      _mm512_castps_si512(cos_x), sign);
+
+		_mm512_storeu_ps(data + i, _mm512_fmadd_ps(_mm512_castsi512_ps(sin_i),
+		                                           _mm512_castsi512_ps(cos_i),
+		                                           _mm512_sqrt_ps(x)));
+	}
+	for (; i < end; ++i) data[i] = arith_poly(data[i]);
+}
+
+// Streaming vector add: regular stores up to the first vector-aligned
+// element of C, non-temporal stores for the body, regular stores for the
+// tail, then an sfence so the write-combining buffers are drained before
+// the thread reports completion
+static void stream_add_scalar(const float* A, const float* B, float* C, dim_t start, dim_t end)
+{
+	for (dim_t i = start; i < end; ++i) C[i] = A[i] + B[i];
+}
+
+// Elements before the first width-byte aligned element of C at or after
+// start (all of [start, end) if there is none)
+static inline dim_t stream_peel_end(const float* C, dim_t start, dim_t end, uintptr_t width)
+{
+	dim_t i = start;
+	while (i < end && (reinterpret_cast<uintptr_t>(C + i) & (width - 1))) ++i;
+	return i;
+}
+
+__attribute__((target("sse2")))
+static void stream_add_sse2(const float* A, const float* B, float* C, dim_t start, dim_t end)
+{
+	dim_t i = stream_peel_end(C, start, end, 16);
+	for (dim_t k = start; k < i; ++k) C[k] = A[k] + B[k];
+	for (; i + 4 <= end; i += 4)
+		_mm_stream_ps(C + i, _mm_add_ps(_mm_loadu_ps(A + i), _mm_loadu_ps(B + i)));
+	for (; i < end; ++i) C[i] = A[i] + B[i];
+	_mm_sfence();
+}
+
+__attribute__((target("avx2")))
+static void stream_add_avx2(const float* A, const float* B, float* C, dim_t start, dim_t end)
+{
+	dim_t i = stream_peel_end(C, start, end, 32);
+	for (dim_t k = start; k < i; ++k) C[k] = A[k] + B[k];
+	for (; i + 8 <= end; i += 8)
+		_mm256_stream_ps(C + i, _mm256_add_ps(_mm256_loadu_ps(A + i), _mm256_loadu_ps(B + i)));
+	for (; i < end; ++i) C[i] = A[i] + B[i];
+	_mm_sfence();
+}
+
+__attribute__((target("avx512f")))
+static void stream_add_avx512(const float* A, const float* B, float* C, dim_t start, dim_t end)
+{
+	dim_t i = stream_peel_end(C, start, end, 64);
+	for (dim_t k = start; k < i; ++k) C[k] = A[k] + B[k];
+	for (; i + 16 <= end; i += 16)
+		_mm512_stream_ps(C + i, _mm512_add_ps(_mm512_loadu_ps(A + i), _mm512_loadu_ps(B + i)));
+	for (; i < end; ++i) C[i] = A[i] + B[i];
+	_mm_sfence();
+}
+
+simd_isa_t detect_simd_isa()
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) return ISA_AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return ISA_AVX2;
+	if (__builtin_cpu_supports("sse2")) return ISA_SSE2;
+	return ISA_SCALAR;
+}
+
+bool parse_simd_isa(const char* name, simd_isa_t* isa)
+{
+	for (int i = ISA_SCALAR; i <= ISA_AVX512; ++i) {
+		if (std::strcmp(name, simd_isa_name(static_cast<simd_isa_t>(i))) == 0) {
+			*isa = static_cast<simd_isa_t>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* simd_isa_name(simd_isa_t isa)
+{
+	switch (isa) {
+		case ISA_SSE2:   return "sse2";
+		case ISA_AVX2:   return "avx2";
+		case ISA_AVX512: return "avx512";
+		default:         return "scalar";
+	}
+}
+
+arith_kernel_t select_arith_kernel(simd_isa_t isa)
+{
+	switch (isa) {
+		case ISA_SSE2:   return arith_sse2;
+		case ISA_AVX2:   return arith_avx2;
+		case ISA_AVX512: return arith_avx512;
+		default:         return arith_scalar;
+	}
+}
+
+stream_add_kernel_t select_stream_add_kernel(simd_isa_t isa)
+{
+	switch (isa) {
+		case ISA_SSE2:   return stream_add_sse2;
+		case ISA_AVX2:   return stream_add_avx2;
+		case ISA_AVX512: return stream_add_avx512;
+		default:         return stream_add_scalar;
+	}
+}
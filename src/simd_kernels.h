@@ -0,0 +1,43 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include "thread_utils.h"
+
+// Instruction sets the arithmetic kernel is hand-vectorized for
+enum simd_isa_t
+{
+	ISA_SCALAR = 0,   // libm std::sqrt/std::sin/std::cos
+	ISA_SSE2,
+	ISA_AVX2,         // AVX2 + FMA
+	ISA_AVX512        // AVX-512F
+};
+
+// Computes data[i] = sqrt(data[i]) + sin(data[i]) * cos(data[i]) for i in [start, end)
+typedef void (*arith_kernel_t)(float* data, dim_t start, dim_t end);
+
+// Widest instruction set supported by the CPU (from CPUID)
+simd_isa_t detect_simd_isa();
+
+// Parse "scalar", "sse2", "avx2" or "avx512"; returns false on unknown names
+bool parse_simd_isa(const char* name, simd_isa_t* isa);
+
+const char* simd_isa_name(simd_isa_t isa);
+
+// Kernel for the given instruction set. The vector kernels evaluate
+// sin/cos with a Cody-Waite reduction to [-pi/4, pi/4] and minimax
+// polynomials; for |x| <= 8192 the absolute error of sin(x) and cos(x)
+// is below 1.2e-7 (about 1 ulp of values near 1). sqrt is correctly
+// rounded. Tails that do not fill a vector use a scalar version of the
+// same polynomials so every element sees the same accuracy.
+arith_kernel_t select_arith_kernel(simd_isa_t isa);
+
+// Computes C[i] = A[i] + B[i] for i in [start, end), writing C with
+// non-temporal stores that bypass the cache and skip the read for
+// ownership. Elements before the first vector-aligned element of C and
+// the tail use regular stores; the kernel ends with an sfence. The scalar
+// version uses regular stores throughout.
+typedef void (*stream_add_kernel_t)(const float* A, const float* B, float* C, dim_t start, dim_t end);
+
+stream_add_kernel_t select_stream_add_kernel(simd_isa_t isa);
+
+#endif // SIMD_KERNELS_H
@@ -0,0 +1,106 @@
+#ifndef STRUCT_LAYOUTS_H
+#define STRUCT_LAYOUTS_H
+
+#include <cstddef>
+#include "thread_utils.h"
+#include "false_sharing.h"
+
+// Layouts of n elements of Fields float fields over one buffer of
+// floats(n) floats. All of them answer the same questions, so kernels and
+// the sharing analysis are written once as templates over the layout:
+// - field(i, f): address of field f of element i
+// - stride: floats from field f of element i to that of element i + 1,
+//   as long as run(i) says they stay in one run
+// - run(i): elements from i on that are stride apart (n - i unless the
+//   layout is tiled)
+// - block: partition block factor, so thread boundaries fall between runs
+// - access(): the false_sharing.h pattern of field f of [start, end)
+
+// Array of structures: element i is Fields consecutive floats. A struct
+// whose size does not divide the line straddles lines, so a thread
+// boundary between two elements can still split a line.
+template <int Fields>
+class AosLayout
+{
+public:
+	static constexpr dim_t stride = Fields;
+	static constexpr dim_t block  = 1;
+
+	AosLayout(float* base, dim_t n) : base_(base), n_(n) {}
+
+	static dim_t floats(dim_t n) { return n * Fields; }
+
+	float* field(dim_t i, int f) const { return base_ + i * Fields + f; }
+	dim_t  run(dim_t i) const { return n_ - i; }
+
+	access_pattern_t access(int thread, int f, dim_t start, dim_t end, bool write) const
+	{
+		return strided_access(thread, base_ + f, sizeof(float), start * Fields, end * Fields, Fields, write);
+	}
+
+private:
+	float* base_;
+	dim_t  n_;
+};
+
+// Structure of arrays: one array per field, each padded to whole lines so
+// that every field starts on a line when the buffer does
+template <int Fields>
+class SoaLayout
+{
+public:
+	static constexpr dim_t stride = 1;
+	static constexpr dim_t block  = line_block_factor(sizeof(float));
+
+	SoaLayout(float* base, dim_t n) : base_(base), n_(n), ld_(leading_dim(n)) {}
+
+	static dim_t floats(dim_t n) { return Fields * leading_dim(n); }
+
+	float* field(dim_t i, int f) const { return base_ + f * ld_ + i; }
+	dim_t  run(dim_t i) const { return n_ - i; }
+
+	access_pattern_t access(int thread, int f, dim_t start, dim_t end, bool write) const
+	{
+		return contiguous_access(thread, base_ + f * ld_, sizeof(float), start, end, write);
+	}
+
+private:
+	static dim_t leading_dim(dim_t n) { return padded_leading_dim(n, sizeof(float), 64); }
+
+	float* base_;
+	dim_t  n_;
+	dim_t  ld_;
+};
+
+// Array of structures of arrays: tiles of Tile elements, each holding Tile
+// floats of field 0, then Tile of field 1, ... With Tile the SIMD width a
+// tile field is one vector, and with Tile * sizeof(float) a multiple of
+// the line (and the buffer on a line) no tile field shares a line with
+// another field. n must be a multiple of Tile.
+template <int Fields, int Tile>
+class AosoaLayout
+{
+public:
+	static constexpr dim_t stride = 1;
+	static constexpr dim_t block  = Tile;
+
+	AosoaLayout(float* base, dim_t) : base_(base) {}
+
+	static dim_t floats(dim_t n) { return (n + Tile - 1) / Tile * Tile * Fields; }
+
+	float* field(dim_t i, int f) const { return base_ + i / Tile * Tile * Fields + f * Tile + i % Tile; }
+	dim_t  run(dim_t i) const { return Tile - i % Tile; }
+
+	// One pattern element per tile field: Tile floats every Fields tile
+	// fields. start and end must be multiples of Tile, as block ensures.
+	access_pattern_t access(int thread, int f, dim_t start, dim_t end, bool write) const
+	{
+		return strided_access(thread, base_ + f * Tile, Tile * sizeof(float), start / Tile * Fields,
+		                      end / Tile * Fields, Fields, write);
+	}
+
+private:
+	float* base_;
+};
+
+#endif // STRUCT_LAYOUTS_H
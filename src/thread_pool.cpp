@@ -0,0 +1,172 @@
+#include "thread_pool.h"
+#include "thread_utils.h"
+
+#include <climits>
+#include <cstring>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Polls of the generation word before a waiter goes to sleep
+#define BARRIER_SPIN_ITERS 4096
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+static void futex_wait(std::atomic<uint32_t>* addr, uint32_t expected)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+static void futex_wake_all(std::atomic<uint32_t>* addr)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+bool parse_exec_backend(const char* name, exec_backend_t* backend)
+{
+	if (std::strcmp(name, "omp") == 0)  { *backend = BACKEND_OMP;  return true; }
+	if (std::strcmp(name, "pool") == 0) { *backend = BACKEND_POOL; return true; }
+	return false;
+}
+
+const char* exec_backend_name(exec_backend_t backend)
+{
+	return backend == BACKEND_POOL ? "pool" : "omp";
+}
+
+SpinFutexBarrier::SpinFutexBarrier(int num_threads, int spin_iters)
+	: num_threads_(num_threads), spin_iters_(spin_iters), arrived_(0), generation_(0), sleepers_(0)
+{
+}
+
+void SpinFutexBarrier::wait()
+{
+	uint32_t gen = generation_.load(std::memory_order_acquire);
+
+	if (arrived_.fetch_add(1, std::memory_order_acq_rel) == num_threads_ - 1) {
+		// Last thread in: reset for the next phase and release the others.
+		// The generation bump and the sleeper check are sequentially
+		// consistent with the waiters' increment and re-check below, so a
+		// waiter either sees the new generation or is woken.
+		arrived_.store(0, std::memory_order_relaxed);
+		generation_.fetch_add(1);
+		if (sleepers_.load() > 0) futex_wake_all(&generation_);
+		return;
+	}
+
+	for (int i = 0; i < spin_iters_; ++i) {
+		if (generation_.load(std::memory_order_acquire) != gen) return;
+		cpu_relax();
+	}
+
+	sleepers_.fetch_add(1);
+	while (generation_.load() == gen) futex_wait(&generation_, gen);
+	sleepers_.fetch_sub(1);
+}
+
+// Spinning only pays off when every thread has a CPU of its own
+static int pool_spin_iters(int num_threads, std::size_t num_cpus)
+{
+	return static_cast<std::size_t>(num_threads) <= num_cpus ? BARRIER_SPIN_ITERS : 0;
+}
+
+ThreadPool::ThreadPool(int num_threads, const std::vector<int>& cpus)
+	: num_threads_(num_threads), cpus_(cpus),
+	  start_(num_threads, pool_spin_iters(num_threads, available_cpus().size())),
+	  done_(num_threads, pool_spin_iters(num_threads, available_cpus().size())), job_(nullptr), ctx_(nullptr), stop_(false)
+{
+	// The caller runs work_id 0, so it is pinned too for the lifetime of
+	// the pool and gets its original mask back afterwards.
+	CPU_ZERO(&caller_mask_);
+	if (!cpus_.empty()) {
+		pthread_getaffinity_np(pthread_self(), sizeof(caller_mask_), &caller_mask_);
+		pin_thread_to_cpu(cpus_[0]);
+	}
+
+	for (int work_id = 1; work_id < num_threads_; ++work_id)
+		workers_.emplace_back(&ThreadPool::worker_loop, this, work_id);
+}
+
+ThreadPool::~ThreadPool()
+{
+	stop_.store(true, std::memory_order_relaxed);
+	start_.wait();
+	for (std::thread& worker : workers_) worker.join();
+
+	if (!cpus_.empty()) pthread_setaffinity_np(pthread_self(), sizeof(caller_mask_), &caller_mask_);
+}
+
+void ThreadPool::dispatch()
+{
+	start_.wait();
+	job_(ctx_, 0, num_threads_);
+	done_.wait();
+}
+
+void ThreadPool::worker_loop(int work_id)
+{
+	if (!cpus_.empty()) pin_thread_to_cpu(cpus_[work_id % cpus_.size()]);
+
+	for (;;) {
+		start_.wait();
+		if (stop_.load(std::memory_order_relaxed)) return;
+		job_(ctx_, work_id, num_threads_);
+		done_.wait();
+	}
+}
+
+ParallelExecutor::ParallelExecutor(exec_backend_t backend, int num_threads, const std::vector<int>& cpus)
+	: backend_(backend), num_threads_(num_threads), thread_time_(num_threads), counters_(nullptr), tracker_(nullptr),
+	  timeline_(nullptr)
+{
+	if (backend_ == BACKEND_POOL) {
+		pool_.reset(new ThreadPool(num_threads, cpus.empty() ? available_cpus() : cpus));
+		return;
+	}
+
+	// libgomp reuses the same team for regions of the same size, so
+	// pinning once here holds for every later region.
+	if (!cpus.empty()) {
+		run([&](int work_id, int) { pin_thread_to_cpu(cpus[work_id % cpus.size()]); });
+	}
+}
+
+double ParallelExecutor::measure_dispatch(int iterations)
+{
+	auto noop = [](int, int) {};
+	run(noop); // first region spawns the OpenMP team
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) run(noop);
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(end - start).count() / iterations;
+}
+
+bool ParallelExecutor::attach_counters(PerfCounters* counters)
+{
+	std::atomic<int> opened(0);
+	run([&](int work_id, int) {
+		if (counters->open_on_current_thread(work_id)) opened.fetch_add(1);
+	});
+	counters_ = opened.load() > 0 ? counters : nullptr;
+	return counters_ != nullptr;
+}
+
+bool ParallelExecutor::attach_tracker(WriteTracker* tracker)
+{
+	run([&](int work_id, int) { tracker->open_on_current_thread(work_id); });
+	tracker_ = tracker->resolve_backend() ? tracker : nullptr;
+	return tracker_ != nullptr;
+}
+
+void ParallelExecutor::attach_timeline(Timeline* timeline)
+{
+	run([&](int work_id, int) { timeline->open_on_current_thread(work_id); });
+	timeline_ = timeline;
+}
@@ -0,0 +1,170 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <omp.h>
+#include <sched.h>
+#include "perf_counters.h"
+#include "write_tracker.h"
+#include "timeline.h"
+
+// Execution backends for the parallel kernels
+enum exec_backend_t
+{
+	BACKEND_OMP = 0,   // new #pragma omp parallel region per call
+	BACKEND_POOL       // persistent pinned std::thread pool
+};
+
+// Parse "omp" or "pool"; returns false on unknown names
+bool parse_exec_backend(const char* name, exec_backend_t* backend);
+
+const char* exec_backend_name(exec_backend_t backend);
+
+// Barrier that spins for a short while and then sleeps on a futex, so
+// back-to-back dispatches stay in user space while idle workers do not
+// burn their cores. With spin_iters = 0 waiters go straight to the futex,
+// which is the right choice when threads outnumber CPUs.
+class SpinFutexBarrier
+{
+public:
+	SpinFutexBarrier(int num_threads, int spin_iters);
+	void wait();
+
+private:
+	int num_threads_;
+	int spin_iters_;
+	alignas(64) std::atomic<int>      arrived_;
+	alignas(64) std::atomic<uint32_t> generation_;
+	alignas(64) std::atomic<int>      sleepers_;
+};
+
+// Fixed set of worker threads that run the same job with work_id
+// 0..size()-1. Worker work_id is pinned to cpus[work_id] (no pinning when
+// cpus is empty). The calling thread participates as work_id 0, so a pool
+// of N threads starts N-1 workers.
+class ThreadPool
+{
+public:
+	ThreadPool(int num_threads, const std::vector<int>& cpus);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int size() const { return num_threads_; }
+
+	// Run fn(work_id, n_way) on every thread of the pool and wait for all
+	template <typename F>
+	void run(F& fn)
+	{
+		job_ = [](void* ctx, int work_id, int n_way) { (*static_cast<F*>(ctx))(work_id, n_way); };
+		ctx_ = &fn;
+		dispatch();
+	}
+
+private:
+	void dispatch();
+	void worker_loop(int work_id);
+
+	int                      num_threads_;
+	std::vector<int>         cpus_;
+	std::vector<std::thread> workers_;
+	SpinFutexBarrier         start_;
+	SpinFutexBarrier         done_;
+	void                   (*job_)(void*, int, int);
+	void*                    ctx_;
+	std::atomic<bool>        stop_;
+	cpu_set_t                caller_mask_;
+};
+
+// Runs a per-thread function on the selected backend. cpus[work_id] is the
+// CPU of each thread; when empty the pool pins to the allowed CPUs in order
+// and OpenMP threads are left to OMP_PROC_BIND.
+class ParallelExecutor
+{
+public:
+	ParallelExecutor(exec_backend_t backend, int num_threads, const std::vector<int>& cpus = std::vector<int>());
+
+	exec_backend_t backend() const { return backend_; }
+	int num_threads() const { return num_threads_; }
+
+	// Run fn(work_id, n_way) on num_threads() threads
+	template <typename F>
+	void run(F&& fn)
+	{
+		if (backend_ == BACKEND_POOL) {
+			pool_->run(fn);
+			return;
+		}
+		omp_set_num_threads(num_threads_);
+		#pragma omp parallel
+		{
+			fn(omp_get_thread_num(), omp_get_num_threads());
+		}
+	}
+
+	// Like run(), but returns the longest time any thread spent inside
+	// fn. Subtracting it from the wall time of the call leaves the
+	// fork/join and barrier cost of the backend. With attached counters
+	// each thread also counts hardware events around fn, with an
+	// attached, enabled write tracker it samples the writes of fn, and
+	// with an attached, enabled timeline it records when fn ran.
+	template <typename F>
+	double run_timed(F&& fn)
+	{
+		run([&](int work_id, int n_way) {
+			if (counters_) counters_->start(work_id);
+			if (tracker_) tracker_->start(work_id);
+			if (timeline_) timeline_->start(work_id);
+			auto start = std::chrono::steady_clock::now();
+			fn(work_id, n_way);
+			auto end = std::chrono::steady_clock::now();
+			if (timeline_) timeline_->stop(work_id);
+			if (tracker_) tracker_->stop(work_id);
+			if (counters_) counters_->stop(work_id);
+			thread_time_[work_id].seconds = std::chrono::duration<double>(end - start).count();
+		});
+		double slowest = 0.0;
+		for (int i = 0; i < num_threads_; ++i)
+			if (thread_time_[i].seconds > slowest) slowest = thread_time_[i].seconds;
+		return slowest;
+	}
+
+	// Average wall time of dispatching an empty job to all threads
+	double measure_dispatch(int iterations);
+
+	// Open the per-thread event groups on every thread of the backend and
+	// count them in run_timed(). Relies on the backend keeping the same
+	// thread per work_id, which the pool guarantees and libgomp does for
+	// regions of the same size. Returns false if no event could be opened.
+	bool attach_counters(PerfCounters* counters);
+	PerfCounters* counters() const { return counters_; }
+
+	// Same for a write tracker; falls back as WriteTracker::resolve_backend()
+	// does and returns false if no backend is left
+	bool attach_tracker(WriteTracker* tracker);
+	WriteTracker* tracker() const { return tracker_; }
+
+	// Same for a timeline: every thread preallocates its own ring
+	void attach_timeline(Timeline* timeline);
+	Timeline* timeline() const { return timeline_; }
+
+private:
+	// One slot per cache line so the timing itself does not false share
+	struct alignas(64) thread_time_t { double seconds; };
+
+	exec_backend_t              backend_;
+	int                         num_threads_;
+	std::unique_ptr<ThreadPool> pool_;
+	std::vector<thread_time_t>  thread_time_;
+	PerfCounters*               counters_;
+	WriteTracker*               tracker_;
+	Timeline*                   timeline_;
+};
+
+#endif // THREAD_POOL_H
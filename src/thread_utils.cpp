@@ -1,5 +1,8 @@
 #include "thread_utils.h"
 
+#include <pthread.h>
+#include <sched.h>
+
 
 void thread_block_partition
      (
@@ -141,4 +144,155 @@ void thread_block_partition
 			*end   = hi_start + (work_id-n_th_lo+1) * size_hi;
 		}
 	}
-} 
\ No newline at end of file
+}
+
+dim_t alignment_prologue
+     (
+       const void* base,
+       dim_t       elem_size,
+       dim_t       align
+     )
+{
+	dim_t misalign = reinterpret_cast<uintptr_t>(base) % align;
+	if ( misalign == 0 ) return 0;
+
+	// Round up so that the first element of the body starts at or past
+	// the boundary even when elem_size does not divide the gap.
+	return ( align - misalign + elem_size - 1 ) / elem_size;
+}
+
+void thread_block_partition_aligned
+     (
+       dim_t       n_way,
+       dim_t       n,
+       dim_t       bf,
+       dim_t       work_id,
+       bool        handle_edge_low,
+       const void* base,
+       dim_t       elem_size,
+       dim_t       align,
+       dim_t*      start,
+       dim_t*      end
+     )
+{
+	if ( n_way == 1 ) { *start = 0; *end = n; return; }
+
+	// The prologue up to the first aligned element is peeled off and
+	// given to thread 0, which already owns the lowest addresses, and the
+	// epilogue after the last whole block to thread n_way - 1, which owns
+	// the highest. The whole blocks in between are partitioned as usual;
+	// with bf * elem_size a multiple of align every interior boundary
+	// lands on an aligned address. Handing the epilogue to thread 0
+	// instead would shift every interior boundary by its length, so
+	// handle_edge_low only picks which threads get the extra blocks.
+	dim_t prologue = alignment_prologue( base, elem_size, align );
+	if ( prologue > n ) prologue = n;
+
+	dim_t body = ( n - prologue ) / bf * bf;
+
+	thread_block_partition( n_way, body, bf, work_id, handle_edge_low, start, end );
+	*start += prologue;
+	*end   += prologue;
+	if ( work_id == 0 )         *start = 0;
+	if ( work_id == n_way - 1 ) *end   = n;
+}
+
+dim_t padded_leading_dim
+     (
+       dim_t      n,
+       dim_t      elem_size,
+       dim_t      align
+     )
+{
+	dim_t row_bytes = n * elem_size;
+	dim_t padded    = ( row_bytes + align - 1 ) / align * align;
+
+	// Elements that do not divide the line cannot keep every row aligned;
+	// pad to whole elements and leave the rows where they fall
+	return ( padded + elem_size - 1 ) / elem_size;
+}
+
+void thread_grid_factor
+     (
+       dim_t      nt,
+       dim_t      m,
+       dim_t      n,
+       dim_t*     m_way,
+       dim_t*     n_way
+     )
+{
+	double best = 0.0;
+
+	*m_way = nt;
+	*n_way = 1;
+	for ( dim_t ir = nt; ir >= 1; --ir )
+	{
+		if ( nt % ir != 0 ) continue;
+
+		// Aspect ratio of the tile, >= 1; strictly better only, so the
+		// first (largest) row count wins ties
+		double tile_m = static_cast<double>( m ) / ir;
+		double tile_n = static_cast<double>( n ) / ( nt / ir );
+		double aspect = tile_m > tile_n ? tile_m / tile_n : tile_n / tile_m;
+		if ( ir == nt || aspect < best )
+		{
+			best   = aspect;
+			*m_way = ir;
+			*n_way = nt / ir;
+		}
+	}
+}
+
+void thread_tile_partition
+     (
+       dim_t       m_way,
+       dim_t       n_way,
+       dim_t       m,
+       dim_t       n,
+       dim_t       work_id,
+       bool        align_cols,
+       const void* base,
+       dim_t       elem_size,
+       dim_t       align,
+       dim_t*      row_start,
+       dim_t*      row_end,
+       dim_t*      col_start,
+       dim_t*      col_end
+     )
+{
+	dim_t ir = work_id / n_way;
+	dim_t jr = work_id % n_way;
+
+	thread_block_partition( m_way, m, 1, ir, false, row_start, row_end );
+
+	if ( align_cols )
+	{
+		dim_t bf = line_block_factor( elem_size, align );
+		thread_block_partition_aligned( n_way, n, bf, jr, false, base, elem_size, align, col_start, col_end );
+	}
+	else
+	{
+		thread_block_partition( n_way, n, 1, jr, false, col_start, col_end );
+	}
+}
+
+std::vector<int> available_cpus()
+{
+	std::vector<int> cpus;
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+			if (CPU_ISSET(cpu, &mask)) cpus.push_back(cpu);
+	}
+	if (cpus.empty()) cpus.push_back(0);
+	return cpus;
+}
+
+bool pin_thread_to_cpu(int cpu)
+{
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+	return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+}
@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 #include <omp.h>
 
 // Type definitions (adjust as needed for your project)
@@ -20,4 +21,138 @@ void thread_block_partition
        dim_t*     end
      );
 
+// Number of elements of elem_size bytes from base up to the first element
+// that starts on an align-byte boundary (0 if base is aligned)
+dim_t alignment_prologue
+     (
+       const void* base,
+       dim_t       elem_size,
+       dim_t       align
+     );
+
+// Like thread_block_partition(), but for the array at base: the elements
+// before the first align-byte boundary go to work_id 0, those after the
+// last whole block to work_id n_way - 1, and the rest is split in
+// multiples of bf, so with bf * elem_size a multiple of align no two
+// threads share a cache line even when base itself is misaligned.
+// handle_edge_low only chooses whether the low or the high threads get
+// the extra blocks; the epilogue always stays on the high edge.
+void thread_block_partition_aligned
+     (
+       dim_t       n_way,
+       dim_t       n,
+       dim_t       bf,
+       dim_t       work_id,
+       bool        handle_edge_low,
+       const void* base,
+       dim_t       elem_size,
+       dim_t       align,
+       dim_t*      start,
+       dim_t*      end
+     );
+
+// Block factor of one cache line of elem_size-byte elements, for
+// thread_block_partition() and thread_block_partition_aligned(). Elements
+// larger than a line use single elements; for sizes that do not divide the
+// line the blocks are the largest whole number of elements that fit.
+constexpr dim_t line_block_factor(dim_t elem_size, dim_t line_size = 64)
+{
+	return elem_size >= line_size ? 1 : line_size / elem_size;
+}
+
+// Leading dimension (elements from the start of one row to the next) of a
+// row-major matrix with n columns, rounded up to whole align-byte lines so
+// that every row starts on a line when the first one does
+dim_t padded_leading_dim
+     (
+       dim_t      n,
+       dim_t      elem_size,
+       dim_t      align
+     );
+
+// Factor nt threads into an m_way x n_way grid over an m x n matrix with
+// tiles as close to square as possible; ties go to more row panels, since
+// with a leading dimension from padded_leading_dim() a row boundary never
+// splits a line of a row-major matrix. With a tight ld that is not a whole
+// number of lines, row boundaries can split lines too.
+void thread_grid_factor
+     (
+       dim_t      nt,
+       dim_t      m,
+       dim_t      n,
+       dim_t*     m_way,
+       dim_t*     n_way
+     );
+
+// Tile of work_id on an m_way x n_way grid (work_ids numbered along the
+// grid's rows) over an m x n row-major matrix at base. m_way = nt gives
+// row panels, n_way = nt column panels. Rows are split into blocks of
+// single rows. With align_cols the columns are split like
+// thread_block_partition_aligned() on the first row, in whole lines of
+// elements, so with a leading dimension from padded_leading_dim() no
+// column boundary splits a line of any row; otherwise they are split as
+// evenly as possible, element by element.
+void thread_tile_partition
+     (
+       dim_t       m_way,
+       dim_t       n_way,
+       dim_t       m,
+       dim_t       n,
+       dim_t       work_id,
+       bool        align_cols,
+       const void* base,
+       dim_t       elem_size,
+       dim_t       align,
+       dim_t*      row_start,
+       dim_t*      row_end,
+       dim_t*      col_start,
+       dim_t*      col_end
+     );
+
+// A T that starts on an Align-byte boundary and is padded to a multiple of
+// Align bytes, so two Padded<T> never share a line. Align = 64 isolates a
+// cache line; 128 also keeps the adjacent-line prefetcher, which pulls
+// lines in 128-byte pairs on many x86 cores, from coupling neighbours.
+// Align = alignof(T) gives the packed layout for comparison.
+template <typename T, std::size_t Align = 64>
+struct alignas(Align) Padded
+{
+	T value;
+};
+
+// One Padded<T> per thread, indexed by work_id, for per-thread counters,
+// accumulators and flags that would otherwise sit side by side in one
+// array or struct
+template <typename T, std::size_t Align = 64>
+class PerThread
+{
+public:
+	explicit PerThread(int num_threads) : slots_(num_threads) {}
+
+	T&       operator[](int work_id)       { return slots_[work_id].value; }
+	const T& operator[](int work_id) const { return slots_[work_id].value; }
+
+	int size() const { return static_cast<int>(slots_.size()); }
+
+	// Bytes between consecutive slots
+	static constexpr std::size_t stride() { return sizeof(Padded<T, Align>); }
+
+	// op(op(init, slot 0), slot 1), ... for reductions after a parallel region
+	template <typename F>
+	T combine(T init, F op) const
+	{
+		for (const Padded<T, Align>& slot : slots_) init = op(init, slot.value);
+		return init;
+	}
+
+private:
+	std::vector< Padded<T, Align> > slots_;
+};
+
+// CPUs the process may run on, in ascending order
+std::vector<int> available_cpus();
+
+// Pin the calling thread to one CPU; returns false if the kernel refuses
+bool pin_thread_to_cpu(int cpu);
+
 #endif // THREAD_UTILS_H 
\ No newline at end of file
@@ -0,0 +1,271 @@
+#include "timeline.h"
+
+#include <algorithm>
+#include <cpuid.h>
+#include <cstdio>
+#include <map>
+#include <sched.h>
+#include "benchmark_common.h"
+
+bool timeline_use_tsc = false;
+
+thread_local timeline_thread_t* timeline_thread = nullptr;
+
+bool invariant_tsc()
+{
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) return false;
+	__cpuid(0x80000007, eax, ebx, ecx, edx);
+	return (edx >> 8) & 1;
+}
+
+const timeline_clock_t& timeline_calibrate()
+{
+	static const timeline_clock_t clock = []() {
+		timeline_clock_t c = { TIMELINE_CLOCK_GETTIME, 1.0 };
+		if (invariant_tsc()) {
+			c.source = TIMELINE_TSC;
+			c.ticks_per_ns = tsc_ticks_per_ns();
+		}
+		timeline_use_tsc = c.source == TIMELINE_TSC;
+		return c;
+	}();
+	return clock;
+}
+
+const char* timeline_source_name(timeline_source_t source)
+{
+	return source == TIMELINE_TSC ? "invariant TSC" : "clock_gettime";
+}
+
+Timeline::Timeline(int num_threads, std::size_t capacity)
+	: enabled_(false), threads_(num_threads)
+{
+	timeline_calibrate();
+	std::size_t rounded = 1;
+	while (rounded < capacity) rounded *= 2;
+	for (timeline_thread_t& t : threads_) {
+		t.mask = rounded - 1;
+		t.cpu = -1;
+	}
+	reset();
+}
+
+void Timeline::open_on_current_thread(int work_id)
+{
+	timeline_thread_t& t = threads_[work_id];
+	t.events.assign(t.mask + 1, timeline_event_t());
+	t.cpu = sched_getcpu();
+}
+
+void Timeline::start(int work_id)
+{
+	if (!enabled_) return;
+	timeline_thread_t& t = threads_[work_id];
+	timeline_thread = &t;
+	t.run_start = timeline_now();
+}
+
+void Timeline::stop(int work_id)
+{
+	if (!enabled_) return;
+	timeline_thread_t& t = threads_[work_id];
+	timeline_record(&t, TIMELINE_RUN, t.run_start, timeline_now(), 0, 0);
+	timeline_thread = nullptr;
+	++t.run;
+}
+
+void Timeline::reset()
+{
+	for (timeline_thread_t& t : threads_) {
+		t.count = 0;
+		t.run = 0;
+		t.run_start = 0;
+	}
+}
+
+std::vector<timeline_event_t> Timeline::events(int work_id) const
+{
+	const timeline_thread_t& t = threads_[work_id];
+	std::vector<timeline_event_t> events;
+	if (t.events.empty()) return events;
+	uint64_t capacity = t.mask + 1;
+	uint64_t first = t.count > capacity ? t.count - capacity : 0;
+	events.reserve(t.count - first);
+	for (uint64_t i = first; i < t.count; ++i) events.push_back(t.events[i & t.mask]);
+	return events;
+}
+
+timeline_summary_t Timeline::summary() const
+{
+	const int n = num_threads();
+	timeline_summary_t s;
+	s.runs = 0;
+	s.busy.assign(n, 0.0);
+	s.start_lag.assign(n, 0.0);
+	s.finish_lag.assign(n, 0.0);
+	s.last_finishes.assign(n, 0);
+	s.imbalance = 1.0;
+	s.straggler = -1;
+	s.start_spread = 0.0;
+	s.finish_spread = 0.0;
+	s.events = 0;
+	s.overwritten = 0;
+
+	// Run events by run index; older runs may be gone from some rings
+	std::map<int, std::vector<const timeline_event_t*>> runs;
+	std::vector<std::vector<timeline_event_t>> rings(n);
+	for (int i = 0; i < n; ++i) {
+		const timeline_thread_t& t = threads_[i];
+		rings[i] = events(i);
+		s.events += t.count;
+		s.overwritten += t.count - rings[i].size();
+		for (const timeline_event_t& e : rings[i]) {
+			if (e.kind != TIMELINE_RUN) continue;
+			std::vector<const timeline_event_t*>& run = runs[e.run];
+			run.resize(n, nullptr);
+			run[i] = &e;
+		}
+	}
+
+	const double ns_per_tick = 1.0 / timeline_calibrate().ticks_per_ns;
+	for (const auto& entry : runs) {
+		const std::vector<const timeline_event_t*>& run = entry.second;
+		if (std::find(run.begin(), run.end(), nullptr) != run.end()) continue;
+		uint64_t first_start = run[0]->start, last_start = run[0]->start;
+		uint64_t first_end = run[0]->end, last_end = run[0]->end;
+		int last = 0;
+		for (int i = 1; i < n; ++i) {
+			first_start = std::min(first_start, run[i]->start);
+			last_start = std::max(last_start, run[i]->start);
+			first_end = std::min(first_end, run[i]->end);
+			if (run[i]->end > last_end) { last_end = run[i]->end; last = i; }
+		}
+		for (int i = 0; i < n; ++i) {
+			s.busy[i] += (run[i]->end - run[i]->start) * ns_per_tick;
+			s.start_lag[i] += (run[i]->start - first_start) * ns_per_tick;
+			s.finish_lag[i] += (run[i]->end - first_end) * ns_per_tick;
+		}
+		++s.last_finishes[last];
+		s.start_spread += (last_start - first_start) * ns_per_tick;
+		s.finish_spread += (last_end - first_end) * ns_per_tick;
+		++s.runs;
+	}
+	if (s.runs == 0) return s;
+
+	// Nanosecond sums to seconds per run
+	const double scale = 1e-9 / s.runs;
+	double total_busy = 0.0, max_busy = 0.0;
+	for (int i = 0; i < n; ++i) {
+		s.busy[i] *= scale;
+		s.start_lag[i] *= scale;
+		s.finish_lag[i] *= scale;
+		total_busy += s.busy[i];
+		max_busy = std::max(max_busy, s.busy[i]);
+	}
+	s.start_spread *= scale;
+	s.finish_spread *= scale;
+	s.imbalance = total_busy > 0.0 ? max_busy / (total_busy / n) : 1.0;
+	s.straggler = static_cast<int>(std::max_element(s.last_finishes.begin(), s.last_finishes.end())
+	                               - s.last_finishes.begin());
+	return s;
+}
+
+ChromeTraceWriter::ChromeTraceWriter()
+	: origin_(0), ticks_per_us_(1.0), first_(true), next_pid_(0)
+{
+}
+
+ChromeTraceWriter::~ChromeTraceWriter()
+{
+	close();
+}
+
+bool ChromeTraceWriter::open(const std::string& path)
+{
+	ticks_per_us_ = timeline_calibrate().ticks_per_ns * 1e3;
+	out_.open(path, std::ios::trunc);
+	if (!out_) return false;
+	path_ = path;
+	origin_ = timeline_now();
+	first_ = true;
+	next_pid_ = 0;
+	out_ << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	return true;
+}
+
+void ChromeTraceWriter::begin_event()
+{
+	out_ << (first_ ? "\n" : ",\n");
+	first_ = false;
+}
+
+static std::string json_string(const std::string& text)
+{
+	std::string quoted = "\"";
+	for (char c : text) {
+		if (c == '"' || c == '\\') quoted += '\\';
+		quoted += c;
+	}
+	return quoted + "\"";
+}
+
+int ChromeTraceWriter::add(const Timeline& timeline, const std::string& name)
+{
+	if (!out_.is_open()) return -1;
+	int pid = next_pid_++;
+	char buffer[256];
+	begin_event();
+	out_ << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":" << json_string(name) << "}}";
+	begin_event();
+	out_ << "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"sort_index\":" << pid << "}}";
+
+	for (int i = 0; i < timeline.num_threads(); ++i) {
+		begin_event();
+		out_ << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << i
+		     << ",\"args\":{\"name\":\"work " << i << " (cpu " << timeline.cpu(i) << ")\"}}";
+		for (const timeline_event_t& e : timeline.events(i)) {
+			// Events before open() would get negative timestamps
+			if (e.start < origin_) continue;
+			double ts = (e.start - origin_) / ticks_per_us_;
+			double dur = (e.end - e.start) / ticks_per_us_;
+			if (e.kind == TIMELINE_RUN)
+				std::snprintf(buffer, sizeof(buffer),
+				              "{\"name\":\"run\",\"cat\":\"run\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,"
+				              "\"dur\":%.3f,\"args\":{\"run\":%d}}", pid, i, ts, dur, e.run);
+			else
+				std::snprintf(buffer, sizeof(buffer),
+				              "{\"name\":\"chunk\",\"cat\":\"chunk\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,"
+				              "\"dur\":%.3f,\"args\":{\"run\":%d,\"first\":%lld,\"last\":%lld}}", pid, i, ts, dur,
+				              e.run, static_cast<long long>(e.first), static_cast<long long>(e.last));
+			begin_event();
+			out_ << buffer;
+		}
+	}
+	out_.flush();
+	return pid;
+}
+
+void ChromeTraceWriter::close()
+{
+	if (!out_.is_open()) return;
+	out_ << "\n]}\n";
+	out_.close();
+}
+
+void print_timeline_summary(const timeline_summary_t& summary, const Timeline& timeline)
+{
+	if (summary.runs == 0) {
+		std::printf("⏱️  Timeline: no complete run in the rings\n");
+		return;
+	}
+	std::printf("⏱️  Timeline (%s, %d runs, %llu events, %llu overwritten): imbalance %.3f, straggler %d, "
+	            "start spread %.3g us, finish spread %.3g us\n",
+	            timeline_source_name(timeline_calibrate().source), summary.runs,
+	            static_cast<unsigned long long>(summary.events), static_cast<unsigned long long>(summary.overwritten),
+	            summary.imbalance, summary.straggler, summary.start_spread * 1e6, summary.finish_spread * 1e6);
+	std::printf("   ⏱️  thread   cpu    busy_us  start_lag_us  finish_lag_us  last\n");
+	for (int i = 0; i < timeline.num_threads(); ++i)
+		std::printf("   ⏱️  %6d %5d %10.2f %13.2f %14.2f %5d\n", i, timeline.cpu(i), summary.busy[i] * 1e6,
+		            summary.start_lag[i] * 1e6, summary.finish_lag[i] * 1e6, summary.last_finishes[i]);
+}
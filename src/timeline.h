@@ -0,0 +1,196 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <x86intrin.h>
+
+// Where timeline_now() gets its ticks from
+enum timeline_source_t
+{
+	TIMELINE_TSC = 0,       // rdtsc, when the CPU reports an invariant TSC
+	TIMELINE_CLOCK_GETTIME  // clock_gettime(CLOCK_MONOTONIC) nanoseconds
+};
+
+struct timeline_clock_t
+{
+	timeline_source_t source;
+	double            ticks_per_ns;   // 1 for clock_gettime
+};
+
+// True if CPUID says the TSC runs at a constant rate in every P-, C- and
+// T-state (leaf 0x80000007, EDX bit 8), so ticks are comparable across
+// cores and convertible to time
+bool invariant_tsc();
+
+// Pick the source and calibrate it against CLOCK_MONOTONIC; the first call
+// takes about 50 ms, later ones return the same result
+const timeline_clock_t& timeline_calibrate();
+
+const char* timeline_source_name(timeline_source_t source);
+
+// Set by timeline_calibrate()
+extern bool timeline_use_tsc;
+
+inline uint64_t timeline_now()
+{
+	if (timeline_use_tsc) return __rdtsc();
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+enum timeline_kind_t
+{
+	TIMELINE_RUN = 0,   // a thread's whole share of one run_timed() call
+	TIMELINE_CHUNK      // one range of elements inside it
+};
+
+struct timeline_event_t
+{
+	uint64_t start;   // ticks
+	uint64_t end;
+	int64_t  first;   // element range of a chunk
+	int64_t  last;
+	int32_t  kind;
+	int32_t  run;     // index of the run since the last reset()
+};
+
+// Per-thread ring of events, preallocated by the thread itself. The hooks
+// only touch count and the slot they write; when the ring is full the
+// oldest events are overwritten, so a trace keeps the latest runs.
+struct alignas(64) timeline_thread_t
+{
+	std::vector<timeline_event_t> events;
+	std::size_t                   mask;         // capacity - 1, a power of two
+	uint64_t                      count;        // events recorded since reset()
+	uint64_t                      run_start;
+	int32_t                       run;
+	int                           cpu;          // where the thread was opened
+};
+
+// Ring of the calling thread between Timeline::start() and stop();
+// nullptr while it is not traced
+extern thread_local timeline_thread_t* timeline_thread;
+
+inline void timeline_record(timeline_thread_t* t, timeline_kind_t kind, uint64_t start, uint64_t end,
+                            int64_t first, int64_t last)
+{
+	timeline_event_t& e = t->events[t->count & t->mask];
+	e.start = start;
+	e.end   = end;
+	e.first = first;
+	e.last  = last;
+	e.kind  = kind;
+	e.run   = t->run;
+	++t->count;
+}
+
+// Hooks around a chunk: a thread-local load and a compare on untraced
+// threads, two clock reads and a store into the ring on traced ones
+inline uint64_t timeline_chunk_begin()
+{
+	return timeline_thread ? timeline_now() : 0;
+}
+
+inline void timeline_chunk_end(uint64_t start, int64_t first, int64_t last)
+{
+	timeline_thread_t* t = timeline_thread;
+	if (t) timeline_record(t, TIMELINE_CHUNK, start, timeline_now(), first, last);
+}
+
+// Per-thread timing of the runs whose run event survived in every ring
+struct timeline_summary_t
+{
+	int                 runs;
+	std::vector<double> busy;            // mean seconds of each thread per run
+	std::vector<double> start_lag;       // mean seconds after the first thread of the run started
+	std::vector<double> finish_lag;      // mean seconds after the first thread of the run finished
+	std::vector<int>    last_finishes;   // runs in which the thread finished last
+	double              imbalance;       // slowest mean busy / mean busy
+	int                 straggler;       // work_id that finished last most often, -1 without runs
+	double              start_spread;    // mean seconds between the first and the last start of a run
+	double              finish_spread;   // mean seconds between the first and the last finish of a run
+	uint64_t            events;
+	uint64_t            overwritten;
+};
+
+// Timeline tracing for a fixed set of threads, used like WriteTracker:
+// every thread opens its ring on itself, then brackets the traced code
+// with start()/stop(), which record one TIMELINE_RUN event; the chunk
+// hooks add TIMELINE_CHUNK events in between. Nothing is allocated or
+// written to a file while tracing.
+class Timeline
+{
+public:
+	// capacity events per thread, rounded up to a power of two
+	Timeline(int num_threads, std::size_t capacity);
+
+	Timeline(const Timeline&) = delete;
+	Timeline& operator=(const Timeline&) = delete;
+
+	// Allocate and touch the ring of work_id on the calling thread
+	void open_on_current_thread(int work_id);
+
+	// start()/stop() are no-ops while disabled, so a timeline can stay
+	// attached to an executor for the untraced runs
+	void set_enabled(bool enabled) { enabled_ = enabled; }
+	bool enabled() const { return enabled_; }
+
+	void start(int work_id);
+	void stop(int work_id);
+	void reset();
+
+	int num_threads() const { return static_cast<int>(threads_.size()); }
+	int cpu(int work_id) const { return threads_[work_id].cpu; }
+
+	// Events of work_id still in its ring, oldest first
+	std::vector<timeline_event_t> events(int work_id) const;
+
+	// Tracing must be stopped
+	timeline_summary_t summary() const;
+
+private:
+	bool                           enabled_;
+	std::vector<timeline_thread_t> threads_;
+};
+
+// Chrome trace_event JSON (chrome://tracing, Perfetto): one process per
+// add() call, one track per thread, a complete ("X") event per run and
+// chunk. Timestamps are microseconds since open(), and events from before
+// it are left out; the file is valid JSON after close() or destruction.
+class ChromeTraceWriter
+{
+public:
+	ChromeTraceWriter();
+	~ChromeTraceWriter();
+
+	bool open(const std::string& path);
+	bool is_open() const { return out_.is_open(); }
+	const std::string& path() const { return path_; }
+
+	// The events of every thread of timeline as the next process, named
+	// name; returns its pid
+	int add(const Timeline& timeline, const std::string& name);
+
+	void close();
+
+private:
+	void begin_event();
+
+	std::ofstream out_;
+	std::string   path_;
+	uint64_t      origin_;
+	double        ticks_per_us_;
+	bool          first_;
+	int           next_pid_;
+};
+
+// Per-thread table and totals of a summary
+void print_timeline_summary(const timeline_summary_t& summary, const Timeline& timeline);
+
+#endif // TIMELINE_H
@@ -0,0 +1,142 @@
+#include "work_scheduler.h"
+
+#include <cstring>
+
+static inline uint64_t pack_range(dim_t head, dim_t tail)
+{
+	return static_cast<uint64_t>(head) | static_cast<uint64_t>(tail) << 32;
+}
+
+static inline dim_t range_head(uint64_t range) { return static_cast<dim_t>(range & 0xffffffffu); }
+static inline dim_t range_tail(uint64_t range) { return static_cast<dim_t>(range >> 32); }
+
+bool parse_schedule(const char* name, schedule_t* schedule)
+{
+	for (int i = SCHED_STATIC; i < SCHED_NUM_SCHEDULES; ++i) {
+		if (std::strcmp(name, schedule_name(static_cast<schedule_t>(i))) == 0) {
+			*schedule = static_cast<schedule_t>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* schedule_name(schedule_t schedule)
+{
+	switch (schedule) {
+		case SCHED_DYNAMIC: return "dynamic";
+		case SCHED_GUIDED:  return "guided";
+		case SCHED_STEAL:   return "steal";
+		default:            return "static";
+	}
+}
+
+bool schedule_supported(schedule_t schedule, exec_backend_t backend)
+{
+	return (schedule != SCHED_DYNAMIC && schedule != SCHED_GUIDED) || backend == BACKEND_OMP;
+}
+
+chunk_plan_t make_chunk_plan
+     (
+       dim_t       n,
+       const void* base,
+       dim_t       elem_size,
+       dim_t       line_size,
+       dim_t       lines_per_chunk
+     )
+{
+	chunk_plan_t plan;
+	dim_t line_elems = line_size >= elem_size ? line_size / elem_size : 1;
+
+	plan.n           = n;
+	plan.prologue    = alignment_prologue( base, elem_size, line_size );
+	if ( plan.prologue > n ) plan.prologue = n;
+	plan.chunk_elems = line_elems * ( lines_per_chunk ? lines_per_chunk : 1 );
+	plan.num_chunks  = ( plan.prologue ? 1 : 0 )
+	                 + ( n - plan.prologue + plan.chunk_elems - 1 ) / plan.chunk_elems;
+	return plan;
+}
+
+ChunkScheduler::ChunkScheduler(int num_threads)
+	: slots_(num_threads), schedule_(SCHED_STATIC), plan_()
+{
+	reset_stats();
+}
+
+void ChunkScheduler::prepare(schedule_t schedule, const chunk_plan_t& plan)
+{
+	schedule_ = schedule;
+	plan_     = plan;
+
+	dim_t n_way = slots_.size();
+	for (dim_t i = 0; i < n_way; ++i) {
+		dim_t first = 0, last = 0;
+		if (schedule == SCHED_STEAL)
+			thread_block_partition(n_way, plan.num_chunks, 1, i, false, &first, &last);
+		slots_[i].range.store(pack_range(first, last), std::memory_order_relaxed);
+	}
+	// The executor's dispatch publishes the ranges to the workers
+}
+
+void ChunkScheduler::reset_stats()
+{
+	for (thread_slot_t& slot : slots_) {
+		slot.chunks = 0;
+		slot.steals = 0;
+		slot.busy   = 0.0;
+	}
+}
+
+sched_stats_t ChunkScheduler::stats() const
+{
+	sched_stats_t stats = {};
+	double total_busy = 0.0;
+	for (const thread_slot_t& slot : slots_) {
+		stats.chunks += slot.chunks;
+		stats.steals += slot.steals;
+		total_busy   += slot.busy;
+		if (slot.busy > stats.max_busy) stats.max_busy = slot.busy;
+	}
+	stats.mean_busy = slots_.empty() ? 0.0 : total_busy / slots_.size();
+	stats.imbalance = stats.mean_busy > 0.0 ? stats.max_busy / stats.mean_busy : 1.0;
+	return stats;
+}
+
+bool ChunkScheduler::take_chunk(int work_id, dim_t* chunk)
+{
+	std::atomic<uint64_t>& range = slots_[work_id].range;
+	uint64_t cur = range.load(std::memory_order_acquire);
+	for (;;) {
+		dim_t head = range_head(cur), tail = range_tail(cur);
+		if (head >= tail) return false;
+		if (range.compare_exchange_weak(cur, pack_range(head + 1, tail), std::memory_order_acq_rel)) {
+			*chunk = head;
+			return true;
+		}
+	}
+}
+
+// Take the upper half of the first non-empty range after work_id's own,
+// run its first chunk now and keep the rest as the new own range. The own
+// range is empty at this point and only its owner refills an empty range,
+// so a plain store is enough; a range of unclaimed chunks never repeats,
+// so the CAS on the victim cannot succeed on a stale value.
+bool ChunkScheduler::steal_chunks(int work_id, int n_way, dim_t* chunk)
+{
+	for (int v = 1; v < n_way; ++v) {
+		std::atomic<uint64_t>& range = slots_[(work_id + v) % n_way].range;
+		uint64_t cur = range.load(std::memory_order_acquire);
+		for (;;) {
+			dim_t head = range_head(cur), tail = range_tail(cur);
+			if (head >= tail) break;
+			dim_t take = (tail - head + 1) / 2;
+			if (range.compare_exchange_weak(cur, pack_range(head, tail - take), std::memory_order_acq_rel)) {
+				*chunk = tail - take;
+				slots_[work_id].range.store(pack_range(tail - take + 1, tail), std::memory_order_release);
+				++slots_[work_id].steals;
+				return true;
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,193 @@
+#ifndef WORK_SCHEDULER_H
+#define WORK_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <omp.h>
+#include "thread_utils.h"
+#include "thread_pool.h"
+
+// How the chunks of a range are handed to the threads
+enum schedule_t
+{
+	SCHED_STATIC = 0,   // contiguous slab of chunks per thread, as thread_block_partition()
+	SCHED_DYNAMIC,      // OpenMP schedule(dynamic, 1) over the chunks
+	SCHED_GUIDED,       // OpenMP schedule(guided, 1) over the chunks
+	SCHED_STEAL         // per-thread deques of chunks with work stealing
+};
+
+#define SCHED_NUM_SCHEDULES 4
+
+// Parse "static", "dynamic", "guided" or "steal"; returns false on unknown names
+bool parse_schedule(const char* name, schedule_t* schedule);
+
+const char* schedule_name(schedule_t schedule);
+
+// The OpenMP schedules are worksharing loops and need the OpenMP backend
+bool schedule_supported(schedule_t schedule, exec_backend_t backend);
+
+// [0, n) of the array at base cut at its cache lines: chunk 0 is the
+// prologue up to the first line boundary (if any), the others are
+// chunk_elems elements, a whole number of lines, except the last. Every
+// chunk boundary is a line boundary of the array, so whichever threads
+// run two neighbouring chunks never write the same line.
+struct chunk_plan_t
+{
+	dim_t n;
+	dim_t prologue;
+	dim_t chunk_elems;
+	dim_t num_chunks;
+};
+
+chunk_plan_t make_chunk_plan
+     (
+       dim_t       n,
+       const void* base,
+       dim_t       elem_size,
+       dim_t       line_size,
+       dim_t       lines_per_chunk
+     );
+
+inline void chunk_range
+     (
+       const chunk_plan_t& plan,
+       dim_t               chunk,
+       dim_t*              start,
+       dim_t*              end
+     )
+{
+	dim_t first = plan.prologue ? 1 : 0;
+	if ( chunk < first ) { *start = 0; *end = plan.prologue; return; }
+	*start = plan.prologue + ( chunk - first ) * plan.chunk_elems;
+	*end   = *start + plan.chunk_elems < plan.n ? *start + plan.chunk_elems : plan.n;
+}
+
+// Totals since the last reset_stats()
+struct sched_stats_t
+{
+	long long chunks;      // chunks executed
+	long long steals;      // successful steals (each takes one or more chunks)
+	double    imbalance;   // slowest thread's busy time / mean busy time
+	double    max_busy;    // seconds
+	double    mean_busy;
+};
+
+// Runs the chunks of a chunk_plan_t on the threads of a ParallelExecutor
+// with one of the schedules. Usage per run:
+//
+//   sched.prepare(SCHED_STEAL, plan);
+//   exec.run([&](int work_id, int n_way) {
+//       sched.execute(work_id, n_way, [&](dim_t start, dim_t end) { ... });
+//   });
+//
+// Every chunk is a TIMELINE_CHUNK event on a traced thread.
+//
+// For SCHED_STEAL every thread starts with the slab SCHED_STATIC would
+// give it as a range of chunk indices [head, tail). The owner takes chunks
+// from the head; an idle thread steals the upper half of a victim's
+// remaining range from the tail. Head and tail share one 64-bit word per
+// thread updated by CAS, so taking and stealing are lock-free and a chunk
+// is claimed exactly once. Stealing whole chunks keeps the line guarantee
+// of the plan, and stealing from the tail keeps both halves contiguous.
+class ChunkScheduler
+{
+public:
+	explicit ChunkScheduler(int num_threads);
+
+	// Set up the deques for one run; call from a single thread
+	void prepare(schedule_t schedule, const chunk_plan_t& plan);
+
+	void reset_stats();
+	sched_stats_t stats() const;
+
+	// Run fn(start, end) for the chunks of work_id under the prepared
+	// schedule. Must be called by all n_way threads of the run.
+	template <typename F>
+	void execute(int work_id, int n_way, F&& fn)
+	{
+		thread_slot_t& slot = slots_[work_id];
+		auto begin = std::chrono::steady_clock::now();
+		long long chunks = 0;
+		dim_t start, end;
+
+		if ( schedule_ == SCHED_DYNAMIC || schedule_ == SCHED_GUIDED )
+		{
+			long long num_chunks = static_cast<long long>( plan_.num_chunks );
+			if ( schedule_ == SCHED_DYNAMIC )
+			{
+				#pragma omp for schedule(dynamic, 1) nowait
+				for ( long long c = 0; c < num_chunks; ++c )
+				{
+					chunk_range( plan_, c, &start, &end );
+					uint64_t tick = timeline_chunk_begin();
+					fn( start, end );
+					timeline_chunk_end( tick, start, end );
+					++chunks;
+				}
+			}
+			else
+			{
+				#pragma omp for schedule(guided, 1) nowait
+				for ( long long c = 0; c < num_chunks; ++c )
+				{
+					chunk_range( plan_, c, &start, &end );
+					uint64_t tick = timeline_chunk_begin();
+					fn( start, end );
+					timeline_chunk_end( tick, start, end );
+					++chunks;
+				}
+			}
+		}
+		else if ( schedule_ == SCHED_STATIC )
+		{
+			dim_t first, last;
+			thread_block_partition( n_way, plan_.num_chunks, 1, work_id, false, &first, &last );
+			for ( dim_t c = first; c < last; ++c )
+			{
+				chunk_range( plan_, c, &start, &end );
+				uint64_t tick = timeline_chunk_begin();
+				fn( start, end );
+				timeline_chunk_end( tick, start, end );
+				++chunks;
+			}
+		}
+		else
+		{
+			dim_t c;
+			for ( ;; )
+			{
+				if ( !take_chunk( work_id, &c ) && !steal_chunks( work_id, n_way, &c ) ) break;
+				chunk_range( plan_, c, &start, &end );
+				uint64_t tick = timeline_chunk_begin();
+				fn( start, end );
+				timeline_chunk_end( tick, start, end );
+				++chunks;
+			}
+		}
+
+		auto finish = std::chrono::steady_clock::now();
+		slot.chunks += chunks;
+		slot.busy   += std::chrono::duration<double>( finish - begin ).count();
+	}
+
+private:
+	// One cache line per thread so the deques do not false share either
+	struct alignas(64) thread_slot_t
+	{
+		std::atomic<uint64_t> range;   // head in the low, tail in the high 32 bits
+		long long             chunks;
+		long long             steals;
+		double                busy;
+	};
+
+	bool take_chunk(int work_id, dim_t* chunk);
+	bool steal_chunks(int work_id, int n_way, dim_t* chunk);
+
+	std::vector<thread_slot_t> slots_;
+	schedule_t                 schedule_;
+	chunk_plan_t               plan_;
+};
+
+#endif // WORK_SCHEDULER_H
@@ -0,0 +1,331 @@
+#include "write_tracker.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#define MAX_RING_PAGES 256   // data pages of one thread's perf ring buffer
+
+thread_local track_thread_t* tracked_thread = nullptr;
+
+bool parse_track_backend(const char* name, track_backend_t* backend)
+{
+	if (std::strcmp(name, "software") == 0) { *backend = TRACK_SOFTWARE; return true; }
+	if (std::strcmp(name, "perf") == 0)     { *backend = TRACK_PERF;     return true; }
+	return false;
+}
+
+const char* track_backend_name(track_backend_t backend)
+{
+	switch (backend) {
+		case TRACK_SOFTWARE: return "software";
+		case TRACK_PERF:     return "perf";
+		default:             return "off";
+	}
+}
+
+bool write_tracking_compiled()
+{
+#ifdef WRITE_TRACKING
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint64_t default_store_sample_config()
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_is("intel")) return 0x82d0;
+	return 0;
+}
+
+static double now_seconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Writes until the sample after this one: uniform in [1, 2 * period - 1],
+// so the mean gap is period
+static uint64_t next_gap(track_thread_t* t)
+{
+	if (t->period <= 1) return 1;
+	t->rng ^= t->rng << 13;
+	t->rng ^= t->rng >> 7;
+	t->rng ^= t->rng << 17;
+	return 1 + t->rng % (2 * t->period - 1);
+}
+
+void track_sample(track_thread_t* t, const void* addr, std::size_t count, std::size_t elem_size)
+{
+	uint64_t tick = __rdtsc();
+	const uintptr_t base = reinterpret_cast<uintptr_t>(addr);
+
+	// Index in the range of the sampled write, then on by random gaps
+	uint64_t offset = t->countdown - 1;
+	while (offset < count) {
+		if (t->addrs.size() < t->capacity) t->addrs.push_back(base + offset * elem_size);
+		else ++t->dropped;
+		offset += next_gap(t);
+	}
+	t->countdown = offset - count + 1;
+	t->sample_ticks += __rdtsc() - tick;
+}
+
+static long perf_event_open(perf_event_attr* attr)
+{
+	// pid 0, cpu -1: sample the calling thread on whichever CPU it runs
+	return syscall(SYS_perf_event_open, attr, 0, -1, -1, 0);
+}
+
+WriteTracker::WriteTracker(int num_threads, track_backend_t backend, uint64_t period,
+                           std::size_t max_samples, std::size_t line_size, uint64_t raw_config)
+	: requested_(backend), backend_(backend), period_(period > 0 ? period : 1), line_size_(line_size),
+	  raw_config_(raw_config), enabled_(false), threads_(num_threads)
+{
+	for (track_thread_t& t : threads_) {
+		t.period   = period_;
+		t.capacity = max_samples;
+		t.fd       = -1;
+		t.ring     = nullptr;
+		t.ring_bytes = 0;
+		t.addrs.reserve(max_samples);
+	}
+	reset();
+}
+
+WriteTracker::~WriteTracker()
+{
+	for (track_thread_t& t : threads_) {
+		if (t.ring) munmap(t.ring, t.ring_bytes);
+		if (t.fd >= 0) close(t.fd);
+	}
+}
+
+bool WriteTracker::open_on_current_thread(int work_id)
+{
+	if (requested_ != TRACK_PERF) return true;
+	track_thread_t& t = threads_[work_id];
+
+	if (raw_config_ == 0) {
+		std::lock_guard<std::mutex> lock(error_mutex_);
+		if (error_.empty()) error_ = "no store sampling event known for this CPU (--track-raw=)";
+		return false;
+	}
+
+	perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.size           = sizeof(attr);
+	attr.type           = PERF_TYPE_RAW;
+	attr.config         = raw_config_;
+	attr.sample_period  = period_;
+	attr.sample_type    = PERF_SAMPLE_ADDR;
+	attr.precise_ip     = 1;   // PEBS: the data address of the sampled store
+	attr.disabled       = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv     = 1;
+
+	long fd = perf_event_open(&attr);
+	if (fd < 0) {
+		std::lock_guard<std::mutex> lock(error_mutex_);
+		if (error_.empty()) error_ = std::string("store sampling: ") + std::strerror(errno);
+		return false;
+	}
+
+	// One header page plus a power of two of data pages, enough for
+	// capacity samples of 16 bytes (header and address) between drains
+	const std::size_t page = sysconf(_SC_PAGESIZE);
+	std::size_t pages = 1;
+	while (pages < MAX_RING_PAGES && pages * page < t.capacity * 16) pages *= 2;
+	std::size_t bytes = (pages + 1) * page;
+	void* ring = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (ring == MAP_FAILED) {
+		close(fd);
+		std::lock_guard<std::mutex> lock(error_mutex_);
+		if (error_.empty()) error_ = std::string("perf ring buffer: ") + std::strerror(errno);
+		return false;
+	}
+	t.fd = static_cast<int>(fd);
+	t.ring = ring;
+	t.ring_bytes = bytes;
+	return true;
+}
+
+bool WriteTracker::resolve_backend()
+{
+	bool all_open = true;
+	for (const track_thread_t& t : threads_)
+		if (t.fd < 0) all_open = false;
+	if (requested_ == TRACK_PERF && all_open) {
+		backend_ = TRACK_PERF;
+		return true;
+	}
+
+	for (track_thread_t& t : threads_) {
+		if (t.ring) munmap(t.ring, t.ring_bytes);
+		if (t.fd >= 0) close(t.fd);
+		t.ring = nullptr;
+		t.fd = -1;
+	}
+	backend_ = write_tracking_compiled() ? TRACK_SOFTWARE : TRACK_OFF;
+	if (!write_tracking_compiled())
+		error_ += std::string(error_.empty() ? "" : "; ") + "software sampling needs a build with -DWRITE_TRACKING";
+	return backend_ != TRACK_OFF;
+}
+
+void WriteTracker::start(int work_id)
+{
+	if (!enabled_ || backend_ == TRACK_OFF) return;
+	track_thread_t& t = threads_[work_id];
+	t.start_seconds = now_seconds();
+	t.start_tick = __rdtsc();
+	if (backend_ == TRACK_PERF) ioctl(t.fd, PERF_EVENT_IOC_ENABLE, 0);
+	else tracked_thread = &t;
+}
+
+void WriteTracker::stop(int work_id)
+{
+	if (!enabled_ || backend_ == TRACK_OFF) return;
+	track_thread_t& t = threads_[work_id];
+	if (backend_ == TRACK_PERF) {
+		ioctl(t.fd, PERF_EVENT_IOC_DISABLE, 0);
+		uint64_t tick = __rdtsc();
+		drain(t);
+		t.sample_ticks += __rdtsc() - tick;
+	} else {
+		tracked_thread = nullptr;
+	}
+	t.tracked_ticks += __rdtsc() - t.start_tick;
+	t.tracked_seconds += now_seconds() - t.start_seconds;
+}
+
+// Copy len bytes at position pos of the ring's data area, which wraps
+static void ring_copy(const char* data, std::size_t size, uint64_t pos, void* out, std::size_t len)
+{
+	std::size_t at = pos % size;
+	std::size_t first = std::min(len, size - at);
+	std::memcpy(out, data + at, first);
+	std::memcpy(static_cast<char*>(out) + first, data, len - first);
+}
+
+void WriteTracker::drain(track_thread_t& t)
+{
+	perf_event_mmap_page* meta = static_cast<perf_event_mmap_page*>(t.ring);
+	const char* data = static_cast<const char*>(t.ring) + sysconf(_SC_PAGESIZE);
+	const std::size_t size = t.ring_bytes - sysconf(_SC_PAGESIZE);
+
+	uint64_t head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+	uint64_t tail = meta->data_tail;
+	while (tail < head) {
+		perf_event_header header;
+		ring_copy(data, size, tail, &header, sizeof(header));
+		if (header.size == 0) break;
+		if (header.type == PERF_RECORD_SAMPLE) {
+			uint64_t addr;
+			ring_copy(data, size, tail + sizeof(header), &addr, sizeof(addr));
+			if (t.addrs.size() < t.capacity) t.addrs.push_back(addr);
+			else ++t.dropped;
+		} else if (header.type == PERF_RECORD_LOST) {
+			uint64_t lost[2];   // id, lost
+			ring_copy(data, size, tail + sizeof(header), lost, sizeof(lost));
+			t.dropped += lost[1];
+		}
+		tail += header.size;
+	}
+	__atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+}
+
+void WriteTracker::reset()
+{
+	for (std::size_t i = 0; i < threads_.size(); ++i) {
+		track_thread_t& t = threads_[i];
+		t.rng = 0x9e3779b97f4a7c15ULL * (i + 1);
+		t.countdown = next_gap(&t);
+		t.writes = 0;
+		t.dropped = 0;
+		t.sample_ticks = 0;
+		t.tracked_ticks = 0;
+		t.tracked_seconds = 0.0;
+		t.addrs.clear();
+	}
+}
+
+write_tracking_report_t WriteTracker::report() const
+{
+	write_tracking_report_t report;
+	report.backend = backend_;
+	report.period = period_;
+	report.line_size = line_size_;
+	report.writes = 0;
+	report.samples = 0;
+	report.dropped = 0;
+	report.tracked_seconds = 0.0;
+	report.overhead_seconds = 0.0;
+
+	// Samples of every line per thread; threads are visited in order, so
+	// the thread lists come out ascending
+	std::map<uintptr_t, tracked_line_t> lines;
+	for (std::size_t i = 0; i < threads_.size(); ++i) {
+		const track_thread_t& t = threads_[i];
+		report.writes += t.writes;
+		report.samples += t.addrs.size() + t.dropped;
+		report.dropped += t.dropped;
+		report.tracked_seconds = std::max(report.tracked_seconds, t.tracked_seconds);
+		if (t.tracked_ticks > 0)
+			report.overhead_seconds = std::max(report.overhead_seconds,
+			                                   t.tracked_seconds * t.sample_ticks / t.tracked_ticks);
+
+		std::vector<uintptr_t> own(t.addrs.size());
+		for (std::size_t s = 0; s < t.addrs.size(); ++s) own[s] = t.addrs[s] / line_size_;
+		std::sort(own.begin(), own.end());
+		for (std::size_t s = 0; s < own.size(); ) {
+			std::size_t e = s;
+			while (e < own.size() && own[e] == own[s]) ++e;
+			tracked_line_t& line = lines[own[s]];
+			line.line = own[s];
+			line.threads.push_back(static_cast<int>(i));
+			line.samples.push_back(e - s);
+			line.total += e - s;
+			s = e;
+		}
+	}
+
+	report.lines_sampled = lines.size();
+	for (const auto& entry : lines)
+		if (entry.second.threads.size() > 1) report.shared.push_back(entry.second);
+	std::stable_sort(report.shared.begin(), report.shared.end(),
+	                 [](const tracked_line_t& a, const tracked_line_t& b) { return a.total > b.total; });
+	return report;
+}
+
+void print_write_tracking_report(const write_tracking_report_t& report, std::size_t max_lines)
+{
+	std::printf("🔎 Write tracking (%s, 1 in %llu writes): %llu samples", track_backend_name(report.backend),
+	            static_cast<unsigned long long>(report.period), static_cast<unsigned long long>(report.samples));
+	if (report.writes) std::printf(" of %llu writes", static_cast<unsigned long long>(report.writes));
+	std::printf(", %llu dropped, %zu lines, %zu written by more than one thread\n",
+	            static_cast<unsigned long long>(report.dropped), report.lines_sampled, report.shared.size());
+	double fraction = report.tracked_seconds > 0.0 ? report.overhead_seconds / report.tracked_seconds : 0.0;
+	std::printf("   sampling overhead %.3g ms of %.3g ms tracked (%.2f%%)\n",
+	            report.overhead_seconds * 1e3, report.tracked_seconds * 1e3, fraction * 100.0);
+
+	for (std::size_t i = 0; i < report.shared.size() && i < max_lines; ++i) {
+		const tracked_line_t& line = report.shared[i];
+		std::printf("   line 0x%llx: ", static_cast<unsigned long long>(line.line * report.line_size));
+		for (std::size_t k = 0; k < line.threads.size(); ++k)
+			std::printf("%sthread %d x%llu", k ? ", " : "", line.threads[k],
+			            static_cast<unsigned long long>(line.samples[k]));
+		std::printf(" (~%llu writes)\n", static_cast<unsigned long long>(line.total * report.period));
+	}
+	if (report.shared.size() > max_lines)
+		std::printf("   ... %zu more\n", report.shared.size() - max_lines);
+}
@@ -0,0 +1,166 @@
+#ifndef WRITE_TRACKER_H
+#define WRITE_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Where the sampled write addresses come from
+enum track_backend_t
+{
+	TRACK_OFF = 0,
+	TRACK_SOFTWARE,   // TRACK_WRITE()/TRACK_WRITES() in the kernels, built with -DWRITE_TRACKING
+	TRACK_PERF        // perf_event_open(2) store sampling with data addresses (Intel PEBS)
+};
+
+// Parse "software" or "perf"
+bool parse_track_backend(const char* name, track_backend_t* backend);
+const char* track_backend_name(track_backend_t backend);
+
+// True if this build has the software hooks compiled in
+bool write_tracking_compiled();
+
+// Raw config of the sampled store event for this CPU, or 0 if there is no
+// known default. Intel: MEM_INST_RETIRED.ALL_STORES, event 0xD0 umask 0x82.
+// AMD IBS reports data addresses through its own PMU and raw sample
+// records, which are not decoded here.
+uint64_t default_store_sample_config();
+
+// Per-thread sampling state. The hooks only touch countdown and writes on
+// the fast path; everything else belongs to track_sample().
+struct alignas(64) track_thread_t
+{
+	uint64_t               countdown;     // writes until the next sample, 1 = the next one
+	uint64_t               writes;        // writes reported by the hooks
+	uint64_t               rng;           // xorshift state of the sample gaps
+	uint64_t               period;        // mean writes between samples
+	std::size_t            capacity;      // samples kept; later ones are dropped
+	uint64_t               dropped;
+	uint64_t               sample_ticks;  // TSC ticks spent in track_sample() or draining
+	uint64_t               tracked_ticks; // TSC ticks between start() and stop()
+	double                 tracked_seconds;
+	uint64_t               start_tick;
+	double                 start_seconds;
+	std::vector<uintptr_t> addrs;         // address of each kept sample
+	int                    fd;            // perf event, -1 for software sampling
+	void*                  ring;          // perf mmap ring buffer
+	std::size_t            ring_bytes;
+};
+
+// Sampling state of the calling thread between WriteTracker::start() and
+// stop(); nullptr while it is not tracked
+extern thread_local track_thread_t* tracked_thread;
+
+// Slow path of the hooks: record the sampled writes of the count
+// elem_size-byte writes starting at addr
+void track_sample(track_thread_t* t, const void* addr, std::size_t count, std::size_t elem_size);
+
+// count consecutive elem_size-byte writes starting at addr. Costs a
+// thread-local load and a compare unless a sample falls in the range, so
+// kernels call it once per written range, outside the vectorized loop.
+inline void track_writes(const void* addr, std::size_t count, std::size_t elem_size)
+{
+	track_thread_t* t = tracked_thread;
+	if (!t || count == 0) return;
+	t->writes += count;
+	if (count < t->countdown) {
+		t->countdown -= count;
+		return;
+	}
+	track_sample(t, addr, count, elem_size);
+}
+
+// Hooks for the kernels; they compile to nothing without -DWRITE_TRACKING
+#ifdef WRITE_TRACKING
+#define TRACK_WRITE(addr)                     track_writes((addr), 1, 1)
+#define TRACK_WRITES(addr, count, elem_size)  track_writes((addr), (count), (elem_size))
+#else
+#define TRACK_WRITE(addr)                     ((void)0)
+#define TRACK_WRITES(addr, count, elem_size)  ((void)0)
+#endif
+
+// A line that more than one thread wrote in the sampled writes
+struct tracked_line_t
+{
+	uintptr_t             line;      // address / line_size
+	std::vector<int>      threads;   // ascending
+	std::vector<uint64_t> samples;   // per entry of threads
+	uint64_t              total;
+};
+
+struct write_tracking_report_t
+{
+	track_backend_t             backend;
+	uint64_t                    period;
+	std::size_t                 line_size;
+	uint64_t                    writes;            // hooked writes; 0 for perf, which does not count them
+	uint64_t                    samples;
+	uint64_t                    dropped;           // buffer full or lost by the kernel
+	std::size_t                 lines_sampled;
+	std::vector<tracked_line_t> shared;            // most samples first
+	double                      tracked_seconds;   // slowest thread between start() and stop()
+	double                      overhead_seconds;  // slowest thread in track_sample() or draining
+};
+
+// Sampled write tracking for a fixed set of threads, used like
+// PerfCounters: every thread opens its state on itself, then brackets the
+// tracked code with start()/stop(). Every period-th write on average is
+// sampled, with random gaps so that strided or repeating write patterns do
+// not alias with the period, and at most max_samples per thread are kept,
+// so the cost is bounded by writes / period and the memory by
+// max_samples. The time spent sampling is measured and reported.
+class WriteTracker
+{
+public:
+	WriteTracker(int num_threads, track_backend_t backend, uint64_t period,
+	             std::size_t max_samples, std::size_t line_size, uint64_t raw_config);
+	~WriteTracker();
+
+	WriteTracker(const WriteTracker&) = delete;
+	WriteTracker& operator=(const WriteTracker&) = delete;
+
+	// Open the perf event of work_id on the calling thread; nothing to do
+	// for software sampling. Returns false on failure (see error()).
+	bool open_on_current_thread(int work_id);
+
+	// After every thread has opened: if perf sampling failed anywhere,
+	// close it everywhere and fall back to software sampling, or to
+	// TRACK_OFF in builds without the hooks. Returns backend() != TRACK_OFF.
+	bool resolve_backend();
+
+	// start()/stop() are no-ops while disabled, so a tracker can stay
+	// attached to an executor for the untracked runs
+	void set_enabled(bool enabled) { enabled_ = enabled; }
+	bool enabled() const { return enabled_; }
+
+	void start(int work_id);
+	void stop(int work_id);
+	void reset();
+
+	track_backend_t backend() const { return backend_; }
+	track_backend_t requested_backend() const { return requested_; }
+	const std::string& error() const { return error_; }
+
+	// Merge the samples of all threads; tracking must be stopped
+	write_tracking_report_t report() const;
+
+private:
+	void drain(track_thread_t& t);
+
+	track_backend_t             requested_;
+	track_backend_t             backend_;
+	uint64_t                    period_;
+	std::size_t                 line_size_;
+	uint64_t                    raw_config_;
+	bool                        enabled_;
+	std::vector<track_thread_t> threads_;
+	std::string                 error_;
+	std::mutex                  error_mutex_;
+};
+
+// Summary plus the max_lines most sampled shared lines
+void print_write_tracking_report(const write_tracking_report_t& report, std::size_t max_lines = 8);
+
+#endif // WRITE_TRACKER_H